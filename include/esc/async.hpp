@@ -0,0 +1,214 @@
+#pragma once
+
+#include <chrono>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <vector>
+
+#include <esc/event.hpp>
+
+namespace esc {
+
+class Scheduler;
+
+/**
+ * A coroutine that is run by a Scheduler.
+ * @details Created suspended, it starts running once passed to Scheduler::spawn(). The
+ * coroutine frame is destroyed when the coroutine returns. Inside a Task you can
+ * co_await async_read(), async_events() and sleep_for().
+ */
+class Task {
+   public:
+    struct promise_type {
+        Scheduler* scheduler = nullptr;
+
+        promise_type() = default;
+        promise_type(promise_type const&) = delete;
+        auto operator=(promise_type const&) -> promise_type& = delete;
+        ~promise_type();
+
+        [[nodiscard]] auto get_return_object() -> Task;
+        [[nodiscard]] auto initial_suspend() noexcept -> std::suspend_always
+        {
+            return {};
+        }
+        [[nodiscard]] auto final_suspend() noexcept -> std::suspend_never { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+   public:
+    Task(Task&& other) noexcept;
+    auto operator=(Task&& other) noexcept -> Task&;
+
+    Task(Task const&) = delete;
+    auto operator=(Task const&) -> Task& = delete;
+
+    /**
+     * Destroys the coroutine if it was never spawned.
+     */
+    ~Task();
+
+   private:
+    Handle handle_;
+
+   private:
+    explicit Task(Handle handle) : handle_{handle} {}
+
+    friend class Scheduler;
+};
+
+namespace detail {
+
+/**
+ * Awaitable returned by async_read().
+ */
+struct ReadAwaitable {
+    std::optional<Event> event = std::nullopt;
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+    [[nodiscard]] auto await_suspend(Task::Handle handle) -> bool;
+    [[nodiscard]] auto await_resume() -> Event { return *event; }
+};
+
+/**
+ * Awaitable returned by async_events().
+ */
+struct EventsAwaitable {
+    std::vector<Event>* out;
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+    [[nodiscard]] auto await_suspend(Task::Handle handle) -> bool;
+    [[nodiscard]] auto await_resume() const -> std::size_t { return out->size(); }
+};
+
+/**
+ * Awaitable returned by sleep_for().
+ */
+struct SleepAwaitable {
+    std::chrono::milliseconds duration;
+
+    [[nodiscard]] auto await_ready() const noexcept -> bool { return false; }
+    void await_suspend(Task::Handle handle);
+    void await_resume() const noexcept {}
+};
+
+}  // namespace detail
+
+/**
+ * Runs Tasks on the calling thread, resuming each when what it waits on is ready.
+ * @details Input is read through read_events(), so the Scheduler sleeps in poll(2)
+ * until there is input, a window resize or the next timer is due. Do not call read()
+ * while Tasks are waiting on input, they share the same input.
+ */
+class Scheduler {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+   public:
+    Scheduler() = default;
+
+    Scheduler(Scheduler const&) = delete;
+    auto operator=(Scheduler const&) -> Scheduler& = delete;
+
+    /**
+     * Destroys any Tasks that have not returned.
+     */
+    ~Scheduler();
+
+   public:
+    /**
+     * Add a Task to be started by run().
+     * @param task The Task to run, it is owned by the Scheduler from now on.
+     */
+    void spawn(Task task);
+
+    /**
+     * Run Tasks until every spawned Task has returned.
+     * @throws Any exception that escapes a Task.
+     * @throws std::logic_error if Tasks are suspended with nothing left to wake them.
+     */
+    void run();
+
+   private:
+    struct Timer {
+        Clock::time_point when;
+        Task::Handle handle;
+
+        [[nodiscard]] auto operator>(Timer const& other) const -> bool
+        {
+            return when > other.when;
+        }
+    };
+
+    /**
+     * Exactly one of event and events is set.
+     */
+    struct InputWaiter {
+        Task::Handle handle;
+        std::optional<Event>* event;
+        std::vector<Event>* events;
+    };
+
+    std::deque<Task::Handle> ready_;
+    std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+    std::deque<InputWaiter> input_waiters_;
+    std::deque<Event> pending_;
+    std::vector<Event> batch_;
+    std::size_t task_count_ = 0;
+    std::exception_ptr exception_;
+
+   private:
+    /**
+     * Hand pending input to waiting Tasks, in the order they started waiting.
+     */
+    void deliver_input();
+
+    /**
+     * Move every Task whose timer is due to the ready queue.
+     */
+    void wake_timers();
+
+    /**
+     * Return the milliseconds until the next timer is due, or -1 if there are none.
+     */
+    [[nodiscard]] auto next_timeout() const -> int;
+
+    friend struct Task::promise_type;
+    friend struct detail::ReadAwaitable;
+    friend struct detail::EventsAwaitable;
+    friend struct detail::SleepAwaitable;
+};
+
+/**
+ * Suspend the current Task until an input Event is read.
+ * @details The coroutine version of read(), co_await it from a Task.
+ * @return An awaitable that resumes with the Event read.
+ */
+[[nodiscard]] auto async_read() -> detail::ReadAwaitable;
+
+/**
+ * Suspend the current Task until input Events are read, then take every Event ready.
+ * @details The coroutine version of read_events(), co_await it in a loop from a Task
+ * to handle input as a stream of batches. \p out is cleared first.
+ * @param out The vector to hold the Events read, must outlive the co_await.
+ * @return An awaitable that resumes with the number of Events read, at least one.
+ */
+[[nodiscard]] auto async_events(std::vector<Event>& out) -> detail::EventsAwaitable;
+
+/**
+ * Suspend the current Task for \p duration.
+ * @param duration The minimum time to suspend for.
+ * @return An awaitable that resumes once \p duration has passed.
+ */
+[[nodiscard]] auto sleep_for(std::chrono::milliseconds duration)
+    -> detail::SleepAwaitable;
+
+}  // namespace esc
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace esc {
+
+/**
+ * Features of the terminal, as reported by the terminal itself.
+ * @details Filled in by probe_capabilities() and initialize_terminal(). A field is only
+ * set if the terminal replied to the matching request, terminals ignore requests they
+ * do not know.
+ */
+struct Capabilities {
+    /**
+     * True if the terminal replied to the Primary Device Attributes request.
+     */
+    bool replied = false;
+
+    /**
+     * The Primary Device Attributes (DA1) parameters, first is the conformance level.
+     */
+    std::vector<int> device_attributes;
+
+    /**
+     * The terminal type from the Secondary Device Attributes (DA2) reply.
+     */
+    std::optional<int> terminal_id;
+
+    /**
+     * The firmware version from the Secondary Device Attributes (DA2) reply.
+     */
+    std::optional<int> firmware_version;
+
+    /**
+     * The name and version from the XTVERSION reply, like "xterm(390)".
+     */
+    std::string version;
+
+    bool synchronized_output = false;  // DEC private mode 2026.
+    bool bracketed_paste = false;      // DEC private mode 2004.
+    bool sgr_mouse = false;            // DEC private mode 1006.
+    bool sgr_pixel_mouse = false;      // DEC private mode 1016.
+
+    /**
+     * The RGB or Tc capability from XTGETTCAP.
+     */
+    bool true_color = false;
+
+    /**
+     * The colors capability from XTGETTCAP.
+     */
+    std::optional<int> colors;
+
+    auto operator==(Capabilities const&) const -> bool = default;
+};
+
+/**
+ * Ask the terminal which features it supports.
+ * @details Sends DA1, DA2, XTVERSION, DECRQM for modes 2026, 2004, 1006 and 1016, and
+ * XTGETTCAP for RGB, Tc and colors, in a single write. The replies are read and lexed
+ * until the DA1 reply arrives, every terminal replies to DA1 and replies come in
+ * order, or until \p budget runs out. Any other input read in that time is passed on
+ * to read(). Replies that arrive after \p budget are dropped by read(), but with echo
+ * on they are also displayed. Returns a default Capabilities if stdin or stdout is not
+ * a terminal. The result is also returned by capabilities() from then on.
+ * @param budget The maximum time to wait for the replies.
+ * @return The Capabilities reported by the terminal.
+ */
+[[nodiscard]] auto probe_capabilities(
+    std::chrono::milliseconds budget = std::chrono::milliseconds{100}) -> Capabilities;
+
+/**
+ * Return the Capabilities the library uses.
+ * @details Set by probe_capabilities(), and by initialize_terminal(), which uses the
+ * capability cache from an earlier run and probes the terminal if there is no record
+ * or it has expired. When echo is off and input is immediate the cache is also
+ * revalidated, the replies are read by read(). Consulted by begin_frame(),
+ * end_frame(), set(MouseMode) and has_true_color().
+ */
+[[nodiscard]] auto capabilities() -> Capabilities const&;
+
+}  // namespace esc
\ No newline at end of file
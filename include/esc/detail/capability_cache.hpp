@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+#include <esc/capabilities.hpp>
+#include <esc/detail/lexer.hpp>
+
+namespace esc::detail {
+
+/**
+ * Return the path of the capability cache file for the current terminal.
+ * @details The file is in $XDG_CACHE_HOME/escape/, or ~/.cache/escape/, named by a
+ * hash of TERM, TERM_PROGRAM and TERM_PROGRAM_VERSION. The XTVERSION reply is stored
+ * in the file, a terminal that reports a different version replaces the record.
+ * @return The path, or an empty string if there is no cache directory.
+ */
+[[nodiscard]] auto capability_cache_path() -> std::string;
+
+/**
+ * Read the Capabilities stored at \p path by store_capabilities().
+ * @param path The cache file to read, it is memory mapped.
+ * @return The stored Capabilities, or std::nullopt if there is no valid record.
+ */
+[[nodiscard]] auto load_capabilities(std::string const& path)
+    -> std::optional<Capabilities>;
+
+/**
+ * Write \p caps to the cache file at \p path, creating its directory if needed.
+ * @details The file is written beside \p path and renamed over it, so a reader never
+ * sees a partial record. Failure is ignored, the cache is only an optimization.
+ * @param path The cache file to write.
+ * @param caps The Capabilities to store.
+ */
+void store_capabilities(std::string const& path, Capabilities const& caps);
+
+/**
+ * Return the cached Capabilities for this terminal, or probe if there are none.
+ * @details A record of replies is a hit for a week, a record of a probe that timed
+ * out is a hit for an hour, so a slow link does not pay the budget on every run.
+ * With \p revalidate the probe requests are always sent. The replies are picked out
+ * of the input stream by take_probe_reply(), which updates probed_capabilities and
+ * rewrites the cache file once the DA1 reply arrives. A cache hit does not wait for
+ * them, a miss waits up to \p budget and stores a record of the timeout if that runs
+ * out. Without \p revalidate a hit does not query the terminal, a miss calls
+ * probe_capabilities() and stores its result. Returns a default Capabilities if stdin
+ * or stdout is not a terminal.
+ * @param budget     The maximum time to wait for replies on a cache miss.
+ * @param revalidate True if input is read without echo, so replies can arrive later
+ * without being displayed.
+ * @return The Capabilities to start with.
+ */
+[[nodiscard]] auto cached_capabilities(std::chrono::milliseconds budget,
+                                       bool revalidate) -> Capabilities;
+
+/**
+ * Collect probe replies from the input stream, to update the cache at \p path.
+ * @details Called by cached_capabilities() after sending the probe requests.
+ * @param cache_path The cache file to update, may be empty to only update
+ * probed_capabilities.
+ */
+void expect_probe_replies(std::string cache_path);
+
+/**
+ * Return true if probe replies are expected and the DA1 reply has not arrived.
+ */
+[[nodiscard]] auto is_expecting_probe_replies() -> bool;
+
+/**
+ * Read input for read() until the expected probe replies arrive or \p budget runs
+ * out.
+ * @details Defined in io.cpp, which owns the InputParser used by read(). Does nothing
+ * if no replies are expected. Called by uninitialize_terminal() so that replies do
+ * not end up in the shell when the app exits without reading input.
+ * @param budget The maximum time to wait.
+ */
+void drain_probe_replies(std::chrono::milliseconds budget);
+
+/**
+ * Consume \p token if it is a reply to a capability probe.
+ * @details Called by InputParser on each Token. Replies are never input Events,
+ * including those that arrive after probe_capabilities() has stopped waiting.
+ * @param token The Token read from the input stream.
+ * @return True if \p token is a probe reply.
+ */
+[[nodiscard]] auto take_probe_reply(Token const& token) -> bool;
+
+}  // namespace esc::detail
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+namespace esc::detail {
+
+/**
+ * A string with a fixed capacity that can be built in constant expressions.
+ * @details Has the push_back() and append() members used by the sequence formatters,
+ * so it can be filled in the same way as a std::string.
+ * @tparam N The capacity, in bytes.
+ */
+template <std::size_t N>
+class FixedString {
+   public:
+    /**
+     * Append a single char.
+     * @details Appending past the capacity does not compile in a constant expression.
+     * @param c The char to append.
+     */
+    constexpr void push_back(char c) { data_[size_++] = c; }
+
+    /**
+     * Append a string.
+     * @param sv The string to append.
+     */
+    constexpr void append(std::string_view sv)
+    {
+        for (auto c : sv) {
+            this->push_back(c);
+        }
+    }
+
+    /**
+     * Return the number of chars appended.
+     */
+    [[nodiscard]] constexpr auto size() const -> std::size_t { return size_; }
+
+    /**
+     * Return a view of the chars appended.
+     */
+    [[nodiscard]] constexpr auto view() const -> std::string_view
+    {
+        return {data_.data(), size_};
+    }
+
+    [[nodiscard]] constexpr operator std::string_view() const { return this->view(); }
+
+   private:
+    std::array<char, N> data_{};
+    std::size_t size_ = 0;
+};
+
+}  // namespace esc::detail
\ No newline at end of file
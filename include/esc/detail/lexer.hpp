@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace esc::detail {
+
+/**
+ * The kinds of Token read from a terminal's input stream.
+ */
+enum class TokenKind : std::uint8_t {
+    Text,     // A single UTF-8 encoded character or C0 control byte, or a lone ESC.
+    Escaped,  // ESC followed by a single byte, bytes holds that byte.
+    CSI,      // ESC [, bytes holds the parameter, intermediate and final bytes.
+    SS3,      // ESC O, bytes holds the parameter, intermediate and final bytes.
+    OSC,      // ESC ], bytes holds the string, without the BEL or ST terminator.
+    DCS,      // ESC P, bytes holds the string, without the ST terminator.
+    APC,      // ESC _, bytes holds the string, without the ST terminator.
+};
+
+/**
+ * A complete unit of terminal input.
+ * @details bytes is only valid until the next call on the Lexer that produced it.
+ */
+struct Token {
+    TokenKind kind;
+    std::string_view bytes;
+};
+
+/**
+ * Splits terminal input into Tokens, a byte at a time, following the DEC VT500
+ * parser model for escape sequences.
+ * @details Each byte is mapped to a byte class, and a table indexed by the current
+ * state and byte class gives the next state and the action to take. State is kept
+ * between calls, so input can be fed in chunks that split a Token anywhere. SOS and PM
+ * strings are read and dropped. 8-bit C1 controls are not recognized, those bytes are
+ * UTF-8 continuation bytes in the input stream.
+ * @see https://vt100.net/emu/dec_ansi_parser
+ */
+class Lexer {
+   public:
+    /**
+     * Strings longer than this are cut short, the rest of the bytes are dropped.
+     */
+    static constexpr auto max_token_size = std::size_t{1} << 16;
+
+    enum class State : std::uint8_t {
+        Ground,
+        Escape,
+        CSI,
+        SS3,
+        String,
+        StringEscape,
+        UTF8,
+    };
+
+   public:
+    /**
+     * Lex bytes from the front of \p input until a Token is complete.
+     * @details Consumed bytes are removed from \p input. Call again with the rest of
+     * \p input to get the next Token.
+     * @param input The bytes to lex, updated to the bytes not yet consumed.
+     * @return The next Token, or std::nullopt if \p input ran out first.
+     */
+    [[nodiscard]] auto next(std::span<char const>& input) -> std::optional<Token>;
+
+    /**
+     * Resolve an ESC, or the start of a sequence, that is not followed by more input.
+     * @details Call this when no more input is available right away. A lone ESC is a
+     * Text Token. An ESC followed only by the byte that starts a CSI, SS3 or string
+     * sequence is an Escaped Token for that byte, as sent for Alt + key. Any other
+     * partial Token is kept waiting for more input.
+     * @return The resolved Token, or std::nullopt if nothing is resolved.
+     */
+    [[nodiscard]] auto idle() -> std::optional<Token>;
+
+    /**
+     * Return true if part of a Token has been consumed.
+     */
+    [[nodiscard]] auto is_pending() const -> bool { return state_ != State::Ground; }
+
+   private:
+    State state_ = State::Ground;
+    char intro_ = '\0';  // The byte after ESC that started the sequence.
+    TokenKind string_kind_ = TokenKind::OSC;
+    bool drop_string_ = false;  // For SOS and PM strings.
+    std::uint8_t utf8_remaining_ = 0;
+    std::string bytes_;
+
+   private:
+    void collect(char c);
+};
+
+}  // namespace esc::detail
\ No newline at end of file
@@ -91,7 +91,11 @@ class Mask {
         return flags_;
     }
 
-   private:
+   public:
+    /**
+     * Public so that Mask is a structural type and can be a template argument, use the
+     * member functions to access it.
+     */
     std::underlying_type_t<E> flags_;
 
    private:
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <span>
+#include <string>
+#include <string_view>
+
+#include <esc/capabilities.hpp>
+
+namespace esc::detail {
+
+/**
+ * Set by probe_capabilities() and initialize_terminal(), returned by capabilities().
+ */
+inline auto probed_capabilities = Capabilities{};
+
+/**
+ * Every request sent by probe_capabilities() but DA1, which is sent last.
+ */
+inline constexpr auto probe_request = std::string_view{
+    "\033[>c"                      // DA2
+    "\033[>q"                      // XTVERSION
+    "\033[?2026$p"                 // DECRQM synchronized output
+    "\033[?2004$p"                 // DECRQM bracketed paste
+    "\033[?1006$p"                 // DECRQM SGR mouse
+    "\033[?1016$p"                 // DECRQM SGR pixel mouse
+    "\033P+q524742\033\\"          // XTGETTCAP RGB
+    "\033P+q5463\033\\"            // XTGETTCAP Tc
+    "\033P+q636f6c6f7273\033\\"};  // XTGETTCAP colors
+
+/**
+ * Pass bytes read from stdin to the InputParser used by read().
+ * @details Defined in io.cpp, which owns that InputParser. Probe replies in \p bytes
+ * are taken by take_probe_reply(), everything else becomes Events for read().
+ * @param bytes The bytes read from stdin.
+ */
+void feed_input(std::span<char const> bytes);
+
+/**
+ * Write \p request to the terminal and read back the replies.
+ * @details A Primary Device Attributes request is sent after \p request, every
+ * terminal replies to it, so reading stops once the Lexer finds its reply. Canonical
+ * input and echo are turned off while reading so replies are readable and not
+ * displayed. Everything read is also passed to feed_input(), so keys typed during the
+ * query are not lost. Returns an empty string if stdin or stdout is not a terminal.
+ * @param request    The control sequences to send.
+ * @param timeout_ms The maximum time to wait for all replies.
+ * @return All bytes read from stdin, including the Device Attributes reply.
+ */
+[[nodiscard]] auto query_terminal(std::string_view request, int timeout_ms)
+    -> std::string;
+
+/**
+ * Lex the replies to the requests sent by probe_capabilities().
+ * @param replies The bytes read by query_terminal().
+ * @return The Capabilities found in \p replies.
+ */
+[[nodiscard]] auto parse_probe_replies(std::string_view replies) -> Capabilities;
+
+}  // namespace esc::detail
\ No newline at end of file
@@ -15,16 +15,36 @@ extern std::sig_atomic_t sigint_flag;
 namespace esc::detail {
 
 /**
- * Notifies read() and next_state(Initial) that the window has been resized.
+ * Notifies read() that the window has been resized.
  * @details Used by SIGWINCH handler and accessed in esc/io.cpp.
  */
 extern std::sig_atomic_t window_resize_sig;
 
+/**
+ * Incremented by the SIGWINCH handler, so a change means the window was resized.
+ * @details Used by cached_terminal_area() to know when to query the size again.
+ */
+extern std::sig_atomic_t window_resize_count;
+
 /**
  * Install signal handlers for SIGWINCH and SIGINT, if sigint is true.
+ * @details Also creates the pipe returned by resize_fd(), on the first call.
  * @param sigint If true, install a signal handler for SIGINT.
  * @throws std::runtime_error If a signal handler cannot be installed.
  */
 void register_signals(bool sigint);
 
+/**
+ * Return a file descriptor that becomes readable when SIGWINCH is received.
+ * @details Poll this along with the input files to wake up on a window resize. It
+ * stays readable until drain_resize_fd() is called.
+ * @return The read end of the resize pipe, or -1 before register_signals().
+ */
+[[nodiscard]] auto resize_fd() -> int;
+
+/**
+ * Read everything from resize_fd(), setting window_resize_sig if there was anything.
+ */
+void drain_resize_fd();
+
 }  // namespace esc::detail
\ No newline at end of file
@@ -1,11 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
 #include <string>
 #include <string_view>
 
-#include <zzz/coro.hpp>
-
 namespace esc::detail {
 
 /**
@@ -35,25 +34,38 @@ auto u32_to_u8(std::u32string_view sv) -> std::string;
 void u32_to_u8(std::u32string_view sv, std::string& out);
 
 /**
- * Convert a UTF8 array of bytes into a UTF32 char32_t.
- * @param bytes The UTF8 array of bytes to convert. Unused bytes should be null.
- * @return The char32_t bytes.
+ * Append the UTF8 reprensentation of the given char32_t string to \p out.
+ * @details The input must be a valid UTF32 sequence, otherwise UB. Runs of ASCII and
+ * of two byte code points are encoded with SSE2 or AVX2, picked at runtime.
+ * @param sv The char32_t string to convert.
+ * @param out The string to append the utf8 bytes to.
+ */
+void u32_to_u8_append(std::u32string_view sv, std::string& out);
+
+/**
+ * Return the number of bytes in the UTF8 representation of \p c.
+ * @param c The char32_t to measure, must be a valid code point.
+ * @return The length of the UTF8 sequence, from 1 to 4.
  */
 [[nodiscard]]
-auto u8_to_u32(std::array<char, 4> bytes) -> char32_t;
+constexpr auto u8_length(char32_t c) -> std::size_t
+{
+    return c < 0x80 ? 1 : c < 0x800 ? 2 : c < 0x10000 ? 3 : 4;
+}
 
 /**
- * Convert a UTF8 string into a series of UTF32 char32_t.
- * @param sv The UTF8 string to convert.
- * @return A generator of UTF32 char32_t.
+ * Convert a UTF8 array of bytes into a UTF32 char32_t.
+ * @param bytes The UTF8 array of bytes to convert. Unused bytes should be null.
+ * @return The char32_t bytes.
  */
 [[nodiscard]]
-auto u8_string_to_u32(std::string_view sv) -> zzz::Generator<char32_t>;
+auto u8_to_u32(std::array<char, 4> bytes) -> char32_t;
 
 /**
  * Convert a UTF8 string to a UTF32 string.
  * @param sv The UTF8 string to convert.
  * @return A UTF32 std::u32string.
+ * @throws std::runtime_error If the input string is not valid UTF-8.
  */
 [[nodiscard]]
 auto u8_string_to_u32_string(std::string_view sv) -> std::u32string;
@@ -62,7 +74,19 @@ auto u8_string_to_u32_string(std::string_view sv) -> std::u32string;
  * Convert a UTF8 string to a UTF32 string.
  * @param sv The UTF8 string to convert.
  * @param out The u32string to write out the utf32 bytes to, it will be `clear()`ed.
+ * @throws std::runtime_error If the input string is not valid UTF-8.
  */
 void u8_string_to_u32_string(std::string_view sv, std::u32string& out);
 
+/**
+ * Append the UTF32 representation of the given UTF8 string to \p out.
+ * @details Runs of ASCII are widened 16 or 32 bytes at a time with SSE2 or AVX2,
+ * picked at runtime. Other code points are validated and decoded one at a time.
+ * @param sv The UTF8 string to convert.
+ * @param out The u32string to append the code points to.
+ * @throws std::runtime_error If the input string is not valid UTF-8, \p out is left
+ * unchanged.
+ */
+void u8_to_u32_append(std::string_view sv, std::u32string& out);
+
 }  // namespace esc::detail
\ No newline at end of file
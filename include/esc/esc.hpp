@@ -1,16 +1,20 @@
 #pragma once
 
 #include <esc/area.hpp>
+#include <esc/async.hpp>
 #include <esc/brush.hpp>
+#include <esc/capabilities.hpp>
 #include <esc/color.hpp>
 #include <esc/detail/signals.hpp>
 #include <esc/detail/transcode.hpp>
 #include <esc/event.hpp>
 #include <esc/glyph.hpp>
+#include <esc/input_parser.hpp>
 #include <esc/io.hpp>
 #include <esc/key.hpp>
 #include <esc/mouse.hpp>
 #include <esc/point.hpp>
+#include <esc/screen.hpp>
 #include <esc/sequence.hpp>
 #include <esc/terminal.hpp>
 #include <esc/terminfo.hpp>
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <variant>
 
 #include <esc/area.hpp>
@@ -27,6 +28,11 @@ struct MouseRelease {
  */
 struct MouseWheel {
     Mouse mouse;
+
+    /**
+     * The number of wheel steps, more than one if Events were coalesced.
+     */
+    int count = 1;
 };
 
 /**
@@ -69,4 +75,22 @@ using Event = std::variant<MousePress,
                            KeyRelease,
                            Resize>;
 
+/**
+ * When the input for an Event arrived and when it became an Event.
+ * @details Times are from std::chrono::steady_clock, which is CLOCK_MONOTONIC on
+ * Linux.
+ */
+struct EventTiming {
+    /**
+     * When the first byte of the Event was read from its file, or when a window resize
+     * was first noticed.
+     */
+    std::chrono::steady_clock::time_point read;
+
+    /**
+     * When parsing the Event finished.
+     */
+    std::chrono::steady_clock::time_point parsed;
+};
+
 }  // namespace esc
\ No newline at end of file
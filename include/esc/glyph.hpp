@@ -76,8 +76,10 @@ namespace detail {
 [[nodiscard]]
 inline auto utf8_to_glyphs(std::string_view sv) -> std::vector<Glyph>
 {
+    auto const u32 = u8_string_to_u32_string(sv);
     auto glyphs = std::vector<Glyph>{};
-    for (char32_t ch : u8_string_to_u32(sv)) {
+    glyphs.reserve(u32.length());
+    for (char32_t ch : u32) {
         glyphs.push_back({ch});
     }
     return glyphs;
@@ -348,11 +350,7 @@ auto operator+=(T& lhs, std::u32string_view rhs) -> T&
 template <InsertableGlyphString T>
 auto operator+=(T& lhs, std::string_view rhs) -> T&
 {
-    auto inserter = std::inserter(lhs, std::end(lhs));
-    for (char32_t ch : detail::u8_string_to_u32(rhs)) {
-        *inserter = Glyph{.symbol = ch};
-    }
-    return lhs;
+    return lhs += std::u32string_view{detail::u8_string_to_u32_string(rhs)};
 }
 
 template <InsertableGlyphString T>
@@ -400,10 +398,9 @@ template <InsertableGlyphString T>
 [[nodiscard]]
 auto operator+(std::string_view lhs, T rhs) -> T
 {
-    auto inserter = std::inserter(rhs, std::begin(rhs));
-    for (char32_t ch : detail::u8_string_to_u32(lhs)) {
-        *inserter = Glyph{.symbol = ch};
-    }
+    std::ranges::transform(detail::u8_string_to_u32_string(lhs),
+                           std::inserter(rhs, std::begin(rhs)),
+                           [](auto ch) { return Glyph{.symbol = ch}; });
     return rhs;
 }
 
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <optional>
+#include <span>
+#include <string>
+
+#include <esc/detail/lexer.hpp>
+#include <esc/event.hpp>
+#include <esc/mouse.hpp>
+
+namespace esc {
+
+/**
+ * Turns bytes read from the terminal into Events, without reading anything itself.
+ * @details For use from an existing event loop in place of read(). Poll the files from
+ * pollable_fds(), pass the bytes read from each to feed() or feed_scancodes(), call
+ * feed_resize() when the resize file is readable, then call next_event() until it
+ * returns std::nullopt. read() is built on this class.
+ */
+class InputParser {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+   public:
+    /**
+     * Return the files to poll for input.
+     * @details In order: stdin, the tty that scancodes are read from in
+     * KeyMode::Alternate and the file that becomes readable on a window resize. A
+     * file that is not open is -1, poll(2) ignores negative file descriptors.
+     * @return The file descriptors to poll for readability.
+     */
+    [[nodiscard]] static auto pollable_fds() -> std::array<int, 3>;
+
+   public:
+    /**
+     * Parse bytes read from stdin.
+     * @details Escape sequences and UTF-8 characters can be split across calls. In
+     * KeyMode::Alternate, key presses from stdin are dropped, keys are read from the
+     * tty as scancodes instead. Control sequences that are not a known key or mouse
+     * Event are dropped.
+     * @param bytes   The bytes read from stdin.
+     * @param read_at When \p bytes were read, for the EventTiming of their Events.
+     */
+    void feed(std::span<char const> bytes, Clock::time_point read_at = Clock::now());
+
+    /**
+     * Parse scancodes read from the tty in KeyMode::Alternate.
+     * @details Scancodes can be split across calls.
+     * @param bytes   The bytes read from the tty file descriptor.
+     * @param read_at When \p bytes were read, for the EventTiming of their Events.
+     */
+    void feed_scancodes(std::span<char const> bytes,
+                        Clock::time_point read_at = Clock::now());
+
+    /**
+     * Consume the notification on the resize file, next_event() will return a Resize.
+     * @details Call this when the resize file from pollable_fds() is readable.
+     */
+    void feed_resize();
+
+    /**
+     * Resolve input that is waiting on bytes that are not coming, like a lone ESC.
+     * @details Call this once stdin has no more bytes ready. An ESC that is not
+     * followed by anything is the Escape key, not the start of an escape sequence.
+     */
+    void flush();
+
+    /**
+     * Merge runs of mouse Events that have not been taken by next_event() yet.
+     * @details Consecutive MouseMove Events with the same button and modifiers become
+     * the last of them. Consecutive MouseWheel Events in the same direction, with the
+     * same modifiers, become one at the last position with the steps added to count.
+     * Off by default.
+     * @param enabled True to merge mouse Events from now on.
+     */
+    void set_coalescing(bool enabled) { coalesce_ = enabled; }
+
+    /**
+     * Hold back a Resize Event until the window has stopped changing for \p delay.
+     * @details A drag-resize signals many times, only the final size is returned.
+     * Pass resize_timeout() to poll(2) so that next_event() is called once the delay
+     * is over. Zero, the default, returns a Resize as soon as it is signaled.
+     * @param delay The time without a SIGWINCH before a Resize is returned.
+     */
+    void set_resize_debounce(std::chrono::milliseconds delay) { debounce_ = delay; }
+
+    /**
+     * Return the time until a held back Resize Event is due.
+     * @return Milliseconds until next_event() will return the Resize, or -1 if there
+     * is none held back.
+     */
+    [[nodiscard]] auto resize_timeout() const -> int;
+
+    /**
+     * Return the next Event parsed, in the order the input was received.
+     * @details A window resize is returned once all Events before it are returned,
+     * and after the delay from set_resize_debounce(). Its size comes from
+     * cached_terminal_area().
+     * @return The next Event, or std::nullopt if there are none.
+     */
+    [[nodiscard]] auto next_event() -> std::optional<Event>;
+
+    /**
+     * Return when the input for the last Event returned by next_event() was read, and
+     * when it was parsed.
+     */
+    [[nodiscard]] auto last_event_timing() const -> EventTiming { return last_timing_; }
+
+   private:
+    struct Queued {
+        Event event;
+        EventTiming timing;
+    };
+
+    detail::Lexer lexer_;
+    std::string scancodes_;
+    std::deque<Queued> events_;
+    EventTiming last_timing_ = {};
+    Clock::time_point token_read_at_ = {};  // When the current Token began.
+    Clock::time_point resize_read_at_ = {};
+    Mouse::Button previous_button_ = {};  // urxvt mouse release needs this.
+    bool coalesce_ = false;
+    std::chrono::milliseconds debounce_ = std::chrono::milliseconds{0};
+    std::optional<Clock::time_point> resize_due_;
+
+   private:
+    void push(detail::Token const& token);
+};
+
+}  // namespace esc
\ No newline at end of file
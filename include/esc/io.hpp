@@ -1,10 +1,15 @@
 #pragma once
 
+#include <chrono>
 #include <concepts>
+#include <cstddef>
+#include <functional>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <vector>
 
 #include <esc/event.hpp>
 
@@ -14,12 +19,15 @@ namespace esc {
 
 /**
  * Write a single byte to the console via stdout.
+ * @details Bytes are buffered until flush() is called, or the buffer grows past the
+ * size given to set_write_buffer_size().
  * @param c The char to write.
  */
 void write(char c);
 
 /**
  * Write a 4 byte char32_t to the console via stdout.
+ * @details Encoded as UTF-8 directly into the write buffer.
  * @param c The char to write.
  */
 void write(char32_t c);
@@ -32,8 +40,8 @@ void write(std::string_view sv);
 
 /**
  * Write a string to the console via stdout.
- * @details This is an optimization over the std::string_view overload since null
- * terminators are required in std::string but not in std::string_view.
+ * @details Same as the std::string_view overload, this is a better match for
+ * std::string arguments than the char const* overload.
  * @param s The string to write.
  */
 void write(std::string const& s);
@@ -46,7 +54,7 @@ void write(char const* s);
 
 /**
  * Write a u32string_view to the console via stdout.
- * @details Calls write(char32_t) for each element of \p sv.
+ * @details Encoded as UTF-8 directly into the write buffer.
  * @param sv The u32string_view to write.
  */
 void write(std::u32string_view sv);
@@ -71,14 +79,76 @@ void write(Args&&... args)
 
 /**
  * Flush the stdout buffer.
- * @details Sends all buffered bytes from calls to write(...) to the console.
+ * @details Sends all buffered bytes from calls to write(...) to the console with a
+ * single write(2) system call, unless the kernel accepts only part of it. Bytes
+ * written to stdout through stdio are flushed first. Retries on EINTR and waits for
+ * stdout to be writable on EAGAIN.
+ * @throws std::runtime_error if writing to stdout fails.
  */
 void flush();
 
+/**
+ * Set the write buffer size, write(...) will flush() when the buffer grows past it.
+ * @details Defaults to 64KiB. Set this larger than the largest frame you write so that
+ * each frame is sent with one system call from your flush(). Zero disables automatic
+ * flushing; bytes still in the buffer are flushed at program exit.
+ * @param bytes The size of the write buffer, in bytes.
+ */
+void set_write_buffer_size(std::size_t bytes);
+
+/**
+ * Receives the timing of the input that a flush() responds to.
+ * @details Called with the EventTiming of the oldest Event read since the last call,
+ * and the time flush() finished writing.
+ */
+using LatencyHook = std::function<void(EventTiming const& input,
+                                       std::chrono::steady_clock::time_point flushed)>;
+
+/**
+ * Measure input-to-flush latency, like the time from a key press to its repaint.
+ * @details After a flush() that writes bytes, \p hook is called if any Events were
+ * read by read() or read_events() since it was last called. Each report covers the
+ * oldest of those Events, the longest wait in that frame.
+ * @param hook The function to call, an empty function turns reports off.
+ */
+void set_latency_hook(LatencyHook hook);
+
+// SYNCHRONIZED OUTPUT -----------------------------------------------------------------
+
+/**
+ * Begin a synchronized output frame.
+ * @details If the terminal supports synchronized output (DEC private mode 2026), this
+ * writes CSI ? 2026 h and the terminal holds off displaying anything written until
+ * end_frame(), then applies the whole frame at once. Writes nothing if unsupported.
+ * Support is detected by initialize_terminal(). Does not call flush().
+ */
+void begin_frame();
+
+/**
+ * End a synchronized output frame started with begin_frame().
+ * @details Writes CSI ? 2026 l if synchronized output is supported. Does not call
+ * flush(), call it after end_frame() to send the frame.
+ */
+void end_frame();
+
+/**
+ * Calls begin_frame() on construction and end_frame() on destruction.
+ */
+class FrameGuard {
+   public:
+    FrameGuard() { begin_frame(); }
+
+    FrameGuard(FrameGuard const&) = delete;
+    auto operator=(FrameGuard const&) -> FrameGuard& = delete;
+
+    ~FrameGuard() { end_frame(); }
+};
+
 // --------------------------------- Reading -------------------------------------------
 
 /**
  * Blocks until a single input Event is read from stdin.
+ * @details Uses a global InputParser, do not mix with an InputParser of your own.
  * @return The Event read from stdin.
  */
 auto read() -> Event;
@@ -90,4 +160,50 @@ auto read() -> Event;
  */
 auto read(int millisecond_timeout) -> std::optional<Event>;
 
+/**
+ * Return when the input for the last Event returned by read() or read_events() was
+ * read, and when it was parsed.
+ * @details See InputParser::last_event_timing().
+ */
+[[nodiscard]] auto last_event_timing() -> EventTiming;
+
+/**
+ * Merge runs of MouseMove and MouseWheel Events read by read() and read_events().
+ * @details Only Events that have been received but not yet returned are merged, see
+ * InputParser::set_coalescing(). Off by default.
+ * @param enabled True to merge mouse Events from now on.
+ */
+void set_event_coalescing(bool enabled);
+
+/**
+ * Hold back Resize Events read by read() and read_events() until the window has
+ * stopped changing for \p delay, so only the final size of a drag-resize is returned.
+ * @details See InputParser::set_resize_debounce(). Zero, the default, turns it off.
+ * @param delay The time without a SIGWINCH before a Resize is returned.
+ */
+void set_resize_debounce(std::chrono::milliseconds delay);
+
+/**
+ * Read every Event that is ready, up to the size of \p out.
+ * @details Waits up to \p millisecond_timeout for the first Event, then parses every
+ * complete Event already received without waiting again. Use this to handle a burst
+ * of input, like a paste or a flood of mouse moves, before rendering once.
+ * @param out                 The Events read are written to the front of this span.
+ * @param millisecond_timeout The maximum time to wait for the first Event, -1 waits
+ *                            forever.
+ * @return The number of Events written to \p out, zero if the timeout is reached.
+ */
+auto read_events(std::span<Event> out, int millisecond_timeout) -> std::size_t;
+
+/**
+ * Read every Event that is ready into \p out.
+ * @details Same as read_events(std::span<Event>, int) without a limit on the number
+ * of Events. \p out is cleared first, reuse it across calls to keep its capacity.
+ * @param out                 The vector to hold the Events read.
+ * @param millisecond_timeout The maximum time to wait for the first Event, -1 waits
+ *                            forever.
+ * @return The number of Events read, zero if the timeout is reached.
+ */
+auto read_events(std::vector<Event>& out, int millisecond_timeout) -> std::size_t;
+
 }  // namespace esc
\ No newline at end of file
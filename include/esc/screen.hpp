@@ -0,0 +1,114 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <esc/area.hpp>
+#include <esc/glyph.hpp>
+#include <esc/point.hpp>
+#include <esc/sequence.hpp>
+
+namespace esc {
+
+/**
+ * Double-buffered grid of Glyphs representing the terminal display.
+ * @details Glyphs are painted into the next frame, present() then writes only the
+ * cells that differ from the previously presented frame, with the smallest Brush
+ * changes and cursor moves between them. Assumes each Glyph occupies a single
+ * terminal cell and that auto-wrap is off, as set by initialize_terminal().
+ */
+class Screen {
+   public:
+    /**
+     * Construct a Screen of the given size.
+     * @details Both frames start out blank, the first present() repaints every cell.
+     * @param size The width and height of the Screen, in terminal cells.
+     */
+    explicit Screen(Area size);
+
+   public:
+    /**
+     * Return the width and height of the Screen.
+     * @return The width and height of the Screen, in terminal cells.
+     */
+    [[nodiscard]] auto size() const -> Area;
+
+    /**
+     * Change the size of the Screen, blanking both frames.
+     * @details The next present() will repaint every cell.
+     * @param size The new width and height of the Screen, in terminal cells.
+     */
+    void resize(Area size);
+
+    /**
+     * Access the Glyph at \p p in the next frame.
+     * @details No bounds checking is performed.
+     * @param p The Point of the Glyph, Point{0, 0} is the top-left cell.
+     * @return A reference to the Glyph at \p p.
+     */
+    [[nodiscard]] auto operator[](Point p) -> Glyph&;
+
+    /**
+     * Access the Glyph at \p p in the next frame.
+     * @details No bounds checking is performed.
+     * @param p The Point of the Glyph, Point{0, 0} is the top-left cell.
+     * @return A const reference to the Glyph at \p p.
+     */
+    [[nodiscard]] auto operator[](Point p) const -> Glyph const&;
+
+    /**
+     * Set every Glyph in the next frame to \p g.
+     * @param g The Glyph to fill the next frame with.
+     */
+    void fill(Glyph const& g = {});
+
+    /**
+     * Forget what is on the terminal, the next present() will repaint every cell.
+     * @details Call this if something other than this Screen has written to the
+     * terminal, or after a Resize Event.
+     */
+    void invalidate();
+
+    /**
+     * Generate the bytes that update the terminal from the presented frame to the next
+     * frame, and make the next frame the presented frame.
+     * @details The returned view is valid until the next call to render() or
+     * present().
+     * @return The control sequences and text to write to the terminal.
+     */
+    [[nodiscard]] auto render() -> std::string_view;
+
+    /**
+     * Write the difference between the presented frame and the next frame to stdout.
+     * @details Calls on write internally, but does not call flush(). The bytes are
+     * wrapped in begin_frame() and end_frame() so the terminal applies them at once.
+     */
+    void present();
+
+   private:
+    Area size_;
+    std::vector<Glyph> current_;
+    std::vector<Glyph> next_;
+    bool is_valid_ = false;
+    BrushTracker brush_;
+    CursorTracker cursor_;
+    std::string bytes_;
+    std::u32string symbols_;
+
+   private:
+    /**
+     * Append the cheapest way to move the cursor to \p p to bytes_.
+     * @details Considers rewriting the unchanged cells in between as well.
+     * @param p The Point to move the cursor to.
+     */
+    void move_cursor(Point p);
+
+    /**
+     * Encode the symbols written since the last control sequence into bytes_.
+     * @details Symbols are collected so that runs of them are encoded in bulk.
+     */
+    void flush_symbols();
+};
+
+}  // namespace esc
\ No newline at end of file
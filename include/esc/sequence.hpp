@@ -1,6 +1,11 @@
 #pragma once
 
+#include <array>
 #include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <type_traits>
@@ -9,6 +14,7 @@
 #include <esc/brush.hpp>
 #include <esc/color.hpp>
 #include <esc/detail/any_of.hpp>
+#include <esc/detail/fixed_string.hpp>
 #include <esc/point.hpp>
 #include <esc/trait.hpp>
 
@@ -30,6 +36,71 @@ using Cursor = Point;
  */
 [[nodiscard]] auto escape(Cursor p) -> std::string;
 
+/**
+ * Append the control sequence to move the cursor to the specified Point to \p out.
+ * @details Allocation free if \p out has enough capacity.
+ * @param out The string to append the control sequence to.
+ * @param p   The Point to move the cursor to.
+ */
+void escape_to(std::string& out, Cursor p);
+
+/**
+ * Generates the cheapest control sequence to move the cursor from its last known
+ * position to a new Point.
+ * @details Chooses between CR, CR + LF, BS, relative moves (CUU/CUD/CUF/CUB),
+ * absolute column/row moves (CHA/VPA) and a full CUP, by number of bytes. Assumes
+ * every sequence it generates is written to the terminal; text written at the cursor
+ * must be reported with advance(), and invalidate() called if the cursor is moved any
+ * other way. Moves never scroll the screen.
+ */
+class CursorTracker {
+   public:
+    /**
+     * Append the control sequence to move the cursor to \p p to \p out.
+     * @details Appends nothing if the cursor is already at \p p. If the cursor
+     * position is not known, a full CUP is appended.
+     * @param out The string to append the control sequence to.
+     * @param p   The Point to move the cursor to.
+     */
+    void escape_to(std::string& out, Cursor p);
+
+    /**
+     * Get the control sequence to move the cursor to \p p.
+     * @param p The Point to move the cursor to.
+     * @return The control sequence to move the cursor to \p p.
+     */
+    [[nodiscard]] auto escape(Cursor p) -> std::string;
+
+    /**
+     * Return the number of bytes escape_to() would append to move to \p p.
+     * @param p The Point to move the cursor to.
+     * @return The number of bytes of the cheapest move to \p p.
+     */
+    [[nodiscard]] auto cost(Cursor p) const -> std::size_t;
+
+    /**
+     * Record that \p cells cells of text were written at the cursor.
+     * @details The cursor moves right by \p cells. Call invalidate() instead if the
+     * text reached the last column, the cursor position is terminal specific there.
+     * @param cells The number of cells written.
+     */
+    void advance(int cells);
+
+    /**
+     * Forget the cursor position, the next move will be a full CUP.
+     */
+    void invalidate();
+
+    /**
+     * Return the last known cursor position.
+     * @return The cursor position, or std::nullopt if unknown.
+     */
+    [[nodiscard]] auto cursor() const -> std::optional<Cursor>;
+
+   private:
+    std::optional<Cursor> at_;
+};
+
 // CLEAR -------------------------------------------------------------------------------
 
 /**
@@ -45,6 +116,13 @@ struct BlankRow {};
  */
 [[nodiscard]] auto escape(BlankRow) -> std::string;
 
+/**
+ * Append the control sequence to clear the row the cursor is currently at to \p out.
+ * @param out      The string to append the control sequence to.
+ * @param BlankRow The tag type to clear the row the cursor is currently at.
+ */
+void escape_to(std::string& out, BlankRow);
+
 /**
  * Tag type to clear the entire screen.
  */
@@ -57,6 +135,13 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape(BlankScreen) -> std::string;
 
+/**
+ * Append the control sequence to erase everything on the screen to \p out.
+ * @param out         The string to append the control sequence to.
+ * @param BlankScreen The tag type to clear the entire screen.
+ */
+void escape_to(std::string& out, BlankScreen);
+
 // TRAITS ------------------------------------------------------------------------------
 
 /**
@@ -70,11 +155,24 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape(Traits traits) -> std::string;
 
+/**
+ * Append the control sequence to set any number of Traits to \p out.
+ * @details Same sequence as escape(Traits), existing Traits are cleared.
+ * @param out    The string to append the control sequence to.
+ * @param traits The Traits to set.
+ */
+void escape_to(std::string& out, Traits traits);
+
 /**
  * Overload needed so variadic escape() does not infinite recurse.
  */
 [[nodiscard]] auto escape(Trait trait) -> std::string;
 
+/**
+ * Overload needed so variadic escape_to() does not infinite recurse.
+ */
+void escape_to(std::string& out, Trait trait);
+
 /**
  * Get the control sequence to remove all Traits currently set.
  * @details Any text written after will have no Traits.
@@ -99,6 +197,13 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape(ColorBG c) -> std::string;
 
+/**
+ * Append the control sequence to set the background to the specified Color to \p out.
+ * @param out The string to append the control sequence to.
+ * @param c   The Color to set the background to.
+ */
+void escape_to(std::string& out, ColorBG c);
+
 /**
  * Get the control sequence to set the background to the specified xterm palette index.
  * @param c The xterm palette index to set the background to.
@@ -107,6 +212,14 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape_bg(XColor c) -> std::string;
 
+/**
+ * Append the control sequence to set the background to the specified xterm palette
+ * index to \p out.
+ * @param out The string to append the control sequence to.
+ * @param c   The xterm palette index to set the background to.
+ */
+void escape_bg_to(std::string& out, XColor c);
+
 /**
  * Get the control sequence to set the background to the specified terminal true color.
  * @param c The terminal true color to set the background to.
@@ -115,11 +228,25 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape_bg(TrueColor c) -> std::string;
 
+/**
+ * Append the control sequence to set the background to the specified terminal true
+ * color to \p out.
+ * @param out The string to append the control sequence to.
+ * @param c   The terminal true color to set the background to.
+ */
+void escape_bg_to(std::string& out, TrueColor c);
+
 /**
  * Get the control sequence to set the background to the terminal's default bg color.
  */
 [[nodiscard]] auto escape_bg(TermColor c) -> std::string;
 
+/**
+ * Append the control sequence to set the background to the terminal's default bg
+ * color to \p out.
+ */
+void escape_bg_to(std::string& out, TermColor c);
+
 /**
  * Get the last Color that was created with escape(ColorBG).
  * @details May not represent what is on the screen if the last call to escape(ColorBG)
@@ -137,6 +264,13 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape(ColorFG c) -> std::string;
 
+/**
+ * Append the control sequence to set the foreground to the specified Color to \p out.
+ * @param out The string to append the control sequence to.
+ * @param c   The Color to set the foreground to.
+ */
+void escape_to(std::string& out, ColorFG c);
+
 /**
  * Get the control sequence to set the foreground to the specified xterm palette index.
  * @param c The xterm palette index to set the foreground to.
@@ -144,6 +278,14 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape_fg(XColor c) -> std::string;
 
+/**
+ * Append the control sequence to set the foreground to the specified xterm palette
+ * index to \p out.
+ * @param out The string to append the control sequence to.
+ * @param c   The xterm palette index to set the foreground to.
+ */
+void escape_fg_to(std::string& out, XColor c);
+
 /**
  * Get the control sequence to set the foreground to the specified terminal true color.
  * @param c The terminal true color to set the foreground to.
@@ -152,11 +294,25 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape_fg(TrueColor c) -> std::string;
 
+/**
+ * Append the control sequence to set the foreground to the specified terminal true
+ * color to \p out.
+ * @param out The string to append the control sequence to.
+ * @param c   The terminal true color to set the foreground to.
+ */
+void escape_fg_to(std::string& out, TrueColor c);
+
 /**
  * Get the control sequence to set the foreground to the terminal's default fg color.
  */
 [[nodiscard]] auto escape_fg(TermColor c) -> std::string;
 
+/**
+ * Append the control sequence to set the foreground to the terminal's default fg
+ * color to \p out.
+ */
+void escape_fg_to(std::string& out, TermColor c);
+
 /**
  * Get the last Color that was created with escape(ColorFG).
  * @details May not represent what is on the screen if the last call to escape(ColorFG)
@@ -174,6 +330,56 @@ struct BlankScreen {};
  */
 [[nodiscard]] auto escape(Brush b) -> std::string;
 
+/**
+ * Append the control sequence to set Brush Colors and Traits to \p out.
+ * @param out The string to append the control sequence to.
+ * @param b   The Brush to set.
+ */
+void escape_to(std::string& out, Brush b);
+
+/**
+ * Generates the smallest control sequence to change from the last Brush it emitted to
+ * a new Brush.
+ * @details Only Colors and Traits that differ are included, merged into a single
+ * control sequence. If resetting every attribute and setting the new Brush from
+ * scratch is shorter, that is emitted instead. Assumes every sequence it generates is
+ * written to the terminal, and that nothing else changes the terminal's Brush; call
+ * invalidate() if that is not the case. Does not modify the values returned by
+ * traits(), background_color() or foreground_color().
+ */
+class BrushTracker {
+   public:
+    /**
+     * Append the control sequence to change from the last Brush to \p b to \p out.
+     * @details Appends nothing if \p b is the last Brush. If the last Brush is not
+     * known, every attribute is reset and \p b is set in full.
+     * @param out The string to append the control sequence to.
+     * @param b   The Brush to set.
+     */
+    void escape_to(std::string& out, Brush const& b);
+
+    /**
+     * Get the control sequence to change from the last Brush to \p b.
+     * @param b The Brush to set.
+     * @return The control sequence to change from the last Brush to \p b.
+     */
+    [[nodiscard]] auto escape(Brush const& b) -> std::string;
+
+    /**
+     * Forget the last Brush, the next sequence will set every attribute.
+     */
+    void invalidate();
+
+    /**
+     * Return the last Brush a control sequence was generated for.
+     * @return The last Brush, or std::nullopt if unknown.
+     */
+    [[nodiscard]] auto brush() const -> std::optional<Brush>;
+
+   private:
+    std::optional<Brush> brush_;
+};
+
 // CONVENIENCE -------------------------------------------------------------------------
 
 /**
@@ -193,7 +399,329 @@ concept Escapable = detail::
 template <Escapable... Args, typename = std::enable_if_t<(sizeof...(Args) > 1), void>>
 [[nodiscard]] auto escape(Args&&... args) -> std::string
 {
-    return (escape(std::forward<Args>(args)) + ...);
+    auto result = std::string{};
+    (escape_to(result, std::forward<Args>(args)), ...);
+    return result;
+}
+
+/**
+ * Append the control sequences for multiple escapable objects to \p out at once.
+ * @details Reuse \p out across calls to avoid allocations, clear() keeps its capacity.
+ * @tparam Args... A list of escapable types.
+ * @param out     The string to append the control sequences to.
+ * @param args... A list of escapable objects.
+ */
+template <Escapable... Args, typename = std::enable_if_t<(sizeof...(Args) > 1), void>>
+void escape_to(std::string& out, Args&&... args)
+{
+    (escape_to(out, std::forward<Args>(args)), ...);
 }
 
+// FORMATTING --------------------------------------------------------------------------
+
+namespace detail {
+
+/**
+ * Decimal digits of an integer in [0, 255], for color parameters.
+ */
+struct ByteDigits {
+    std::array<char, 3> digits;
+    std::uint8_t size;
+};
+
+/**
+ * Decimal digits of every integer in [0, 255], indexed by value.
+ */
+inline constexpr auto byte_digits = [] {
+    auto table = std::array<ByteDigits, 256>{};
+    for (auto i = 0; i < 256; ++i) {
+        auto& entry = table[static_cast<std::size_t>(i)];
+        auto const hundreds = i / 100;
+        auto const tens = i / 10 % 10;
+        if (hundreds != 0) {
+            entry.digits[entry.size++] = static_cast<char>('0' + hundreds);
+        }
+        if (hundreds != 0 || tens != 0) {
+            entry.digits[entry.size++] = static_cast<char>('0' + tens);
+        }
+        entry.digits[entry.size++] = static_cast<char>('0' + i % 10);
+    }
+    return table;
+}();
+
+/**
+ * The two decimal digits of every integer in [0, 99], "00" to "99".
+ */
+inline constexpr auto digit_pairs = [] {
+    auto table = std::array<char, 200>{};
+    for (auto i = 0; i < 100; ++i) {
+        table[static_cast<std::size_t>(i * 2)] = static_cast<char>('0' + i / 10);
+        table[static_cast<std::size_t>(i * 2 + 1)] = static_cast<char>('0' + i % 10);
+    }
+    return table;
+}();
+
+/**
+ * Append the decimal representation of \p value to \p out, with a table lookup.
+ * @tparam Out  std::string or FixedString.
+ * @param out   The string to append to.
+ * @param value The integer to append.
+ */
+template <typename Out>
+constexpr void append_uint8(Out& out, std::uint8_t value)
+{
+    auto const& entry = byte_digits[value];
+    out.append(std::string_view{entry.digits.data(), entry.size});
+}
+
+/**
+ * Append the decimal representation of \p value to \p out.
+ * @details Values in [0, 255] are a table lookup, larger values are written two
+ * digits at a time, so cursor coordinates up to 65535 take at most three steps.
+ * @tparam Out  std::string or FixedString.
+ * @param out   The string to append to.
+ * @param value The integer to append.
+ */
+template <typename Out>
+constexpr void append_int(Out& out, int value)
+{
+    if (value >= 0 && value < 256) {
+        detail::append_uint8(out, static_cast<std::uint8_t>(value));
+        return;
+    }
+    auto buffer = std::array<char, 11>{};  // Fits INT_MIN.
+    auto first = buffer.size();
+    auto n = static_cast<unsigned>(value);
+    if (value < 0) {
+        n = 0U - n;
+    }
+    while (n >= 100) {
+        auto const pair = static_cast<std::size_t>(n % 100 * 2);
+        n /= 100;
+        buffer[--first] = digit_pairs[pair + 1];
+        buffer[--first] = digit_pairs[pair];
+    }
+    if (n >= 10) {
+        auto const pair = static_cast<std::size_t>(n * 2);
+        buffer[--first] = digit_pairs[pair + 1];
+        buffer[--first] = digit_pairs[pair];
+    }
+    else {
+        buffer[--first] = static_cast<char>('0' + n);
+    }
+    if (value < 0) {
+        buffer[--first] = '-';
+    }
+    out.append(std::string_view{buffer.data() + first, buffer.size() - first});
+}
+
+/**
+ * Translate a single Trait into its control sequence parameter integers.
+ * @details Returns empty string for Trait::None.
+ * @param t The Trait to translate.
+ * @return The control sequence parameter ints as a string.
+ * @throws std::runtime_error If the Trait is invalid.
+ */
+[[nodiscard]] constexpr auto trait_parameters(Trait t) -> std::string_view
+{
+    switch (t) {
+        case Trait::Standout: return "1;7";  // Bold + Inverse
+        case Trait::None: return "";
+        case Trait::Bold: return "1";
+        case Trait::Dim: return "2";
+        case Trait::Italic: return "3";
+        case Trait::Underline: return "4";
+        case Trait::Blink: return "5";
+        case Trait::Inverse: return "7";
+        case Trait::Invisible: return "8";
+        case Trait::CrossedOut: return "9";
+        case Trait::DoubleUnderline: return "21";
+    }
+    throw std::runtime_error{"trait_parameters: Invalid Trait Value"};
+}
+
+/**
+ * Append a mask of traits to \p out as control sequence parameter integers.
+ * @details Each parameter is preceded by a semi-colon.
+ * @param out    The string to append to.
+ * @param traits The traits to translate.
+ */
+template <typename Out>
+constexpr void append_traits(Out& out, Traits traits)
+{
+    auto constexpr last_trait = 512;
+    for (auto i = std::underlying_type_t<Trait>{1}; i <= last_trait; i <<= 1) {
+        if (auto const t = static_cast<Trait>(i); traits.contains(t)) {
+            out.push_back(';');
+            out.append(detail::trait_parameters(t));
+        }
+    }
+}
+
+/**
+ * Append the red, green and blue parameters of \p c to \p out, semi-colon separated.
+ * @param out The string to append to.
+ * @param c   The color to translate.
+ */
+template <typename Out>
+constexpr void append_rgb(Out& out, TrueColor c)
+{
+    detail::append_uint8(out, c.red);
+    out.push_back(';');
+    detail::append_uint8(out, c.green);
+    out.push_back(';');
+    detail::append_uint8(out, c.blue);
+}
+
+// The append_escape functions produce the control sequences for escape(...), without
+// updating traits(), background_color() or foreground_color().
+
+template <typename Out>
+constexpr void append_escape(Out& out, Cursor p)
+{
+    out.append("\033[");
+    detail::append_int(out, p.y + 1);
+    out.push_back(';');
+    detail::append_int(out, p.x + 1);
+    out.push_back('H');
+}
+
+template <typename Out>
+constexpr void append_escape(Out& out, BlankRow)
+{
+    out.append("\033[2K");
+}
+
+template <typename Out>
+constexpr void append_escape(Out& out, BlankScreen)
+{
+    out.append("\033[2J");
+}
+
+template <typename Out>
+constexpr void append_escape(Out& out, Traits traits)
+{
+    out.append("\033[22;23;24;25;27;28;29");
+    detail::append_traits(out, traits);
+    out.push_back('m');
+}
+
+template <typename Out>
+constexpr void append_escape_bg(Out& out, XColor c)
+{
+    out.append("\033[48;5;");
+    detail::append_uint8(out, c.value);
+    out.push_back('m');
+}
+
+template <typename Out>
+constexpr void append_escape_bg(Out& out, TrueColor c)
+{
+    out.append("\033[48;2;");
+    detail::append_rgb(out, c);
+    out.push_back('m');
+}
+
+template <typename Out>
+constexpr void append_escape_bg(Out& out, TermColor)
+{
+    out.append("\033[49m");
+}
+
+template <typename Out>
+constexpr void append_escape_fg(Out& out, XColor c)
+{
+    out.append("\033[38;5;");
+    detail::append_uint8(out, c.value);
+    out.push_back('m');
+}
+
+template <typename Out>
+constexpr void append_escape_fg(Out& out, TrueColor c)
+{
+    out.append("\033[38;2;");
+    detail::append_rgb(out, c);
+    out.push_back('m');
+}
+
+template <typename Out>
+constexpr void append_escape_fg(Out& out, TermColor)
+{
+    out.append("\033[39m");
+}
+
+template <typename Out>
+constexpr void append_escape(Out& out, ColorBG c)
+{
+    std::visit([&out](auto c) { detail::append_escape_bg(out, c); }, c.value);
+}
+
+template <typename Out>
+constexpr void append_escape(Out& out, ColorFG c)
+{
+    std::visit([&out](auto c) { detail::append_escape_fg(out, c); }, c.value);
+}
+
+template <typename Out>
+constexpr void append_escape(Out& out, Brush const& b)
+{
+    detail::append_escape(out, ColorBG{b.background});
+    detail::append_escape(out, ColorFG{b.foreground});
+    detail::append_escape(out, b.traits);
+}
+
+/**
+ * Upper bound on the length of the control sequence for a single Escapable object.
+ * @details The longest is a Brush with two TrueColors and every Trait, at 84 bytes.
+ */
+inline constexpr auto max_escape_length = std::size_t{96};
+
+}  // namespace detail
+
+// COMPILE TIME ------------------------------------------------------------------------
+
+/**
+ * Generate the control sequences for any number of escapable objects at compile time.
+ * @details Produces the same bytes as escape(args...), but does not update traits(),
+ * background_color() or foreground_color(). The result converts to std::string_view
+ * and can be passed to write(...); store it in a constexpr variable so it lives in
+ * static storage, e.g. `static constexpr auto red = escape_c(fg(XColor::Red));`.
+ * @tparam Args... A list of escapable types.
+ * @param args... A list of escapable objects.
+ * @return A fixed capacity string holding the control sequences.
+ */
+template <Escapable... Args>
+[[nodiscard]] consteval auto escape_c(Args... args)
+    -> detail::FixedString<detail::max_escape_length * sizeof...(Args)>
+{
+    auto result = detail::FixedString<detail::max_escape_length * sizeof...(Args)>{};
+    (detail::append_escape(result, args), ...);
+    return result;
+}
+
+namespace detail {
+
+/**
+ * Static storage for seq, sized to fit the control sequences exactly.
+ */
+template <auto... Args>
+inline constexpr auto seq_storage = [] {
+    constexpr auto full = escape_c(Args...);
+    auto result = FixedString<full.size()>{};
+    result.append(full);
+    return result;
+}();
+
+}  // namespace detail
+
+/**
+ * The control sequences for escapable template arguments, generated at compile time.
+ * @details Same bytes as escape_c(Args...), e.g.
+ * `write(seq<Trait::Bold | Trait::Underline>);`. Only Cursor, BlankRow, BlankScreen,
+ * Trait and Traits can be template arguments; use escape_c() for Colors and Brushes.
+ * @tparam Args... A list of escapable objects.
+ */
+template <Escapable auto... Args>
+inline constexpr auto seq = std::string_view{detail::seq_storage<Args...>};
+
 }  // namespace esc
\ No newline at end of file
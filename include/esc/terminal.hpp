@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <utility>
 
 #include <esc/area.hpp>
@@ -108,6 +109,38 @@ void set(MouseMode x);
 
 // CONVENIENCE -------------------------------------------------------------------------
 
+namespace detail {
+
+/**
+ * Settings that are applied through termios, collected so that they can be applied
+ * together.
+ */
+struct TermiosSettings {
+    std::optional<Echo> echo = std::nullopt;
+    std::optional<InputBuffer> input_buffer = std::nullopt;
+    std::optional<Signals> signals = std::nullopt;
+
+    void add(Echo x) { echo = x; }
+    void add(InputBuffer x) { input_buffer = x; }
+    void add(Signals x) { signals = x; }
+};
+
+/**
+ * Types that are applied through termios.
+ */
+template <typename T>
+concept TermiosSetting = AnyOf<T, Echo, InputBuffer, Signals>;
+
+/**
+ * Apply \p settings with a single tcgetattr() and tcsetattr() pair.
+ * @details Uses TCSANOW, so input typed before the change is kept. Does nothing if
+ * \p settings is empty.
+ * @param settings The settings to apply.
+ */
+void set_termios(TermiosSettings const& settings);
+
+}  // namespace detail
+
 /**
  * Types that represent a setting on the terminal.
  */
@@ -117,6 +150,9 @@ concept Setable = detail::
 
 /**
  * Convenience function to set multiple properties at once.
+ * @details Properties are applied in argument order, except that Echo, InputBuffer and
+ * Signals are applied together with a single tcsetattr() call, at the position of the
+ * first of them.
  * @tparam Args The types of the properties to set.
  * @param args The properties to set.
  */
@@ -124,7 +160,27 @@ template <Setable... Args>
 void set(Args&&... args)
 {
     static_assert(sizeof...(Args) > 0, "set(...): Must have at least one argument.");
-    (set(std::forward<Args>(args)), ...);
+    auto termios = detail::TermiosSettings{};
+    (
+        [&] {
+            if constexpr (detail::TermiosSetting<Args>) {
+                termios.add(args);
+            }
+        }(),
+        ...);
+    auto applied = false;
+    (
+        [&] {
+            if constexpr (detail::TermiosSetting<Args>) {
+                if (!std::exchange(applied, true)) {
+                    detail::set_termios(termios);
+                }
+            }
+            else {
+                set(std::forward<Args>(args));
+            }
+        }(),
+        ...);
 }
 
 // INITIALIZE --------------------------------------------------------------------------
@@ -231,10 +287,19 @@ void uninitialize_terminal();
 
 /**
  * Get the width and height of the terminal screen.
- * @details Uses ioctl to get the terminal width and height.
+ * @details Uses a single ioctl to get the terminal width and height.
  * @return The Area (width and height) of the terminal screen.
  * @throws std::runtime_error if ioctl fails.
  */
 [[nodiscard]] auto terminal_area() -> Area;
 
+/**
+ * Get the width and height of the terminal screen, without a system call if possible.
+ * @details Calls terminal_area() the first time, and again only after a SIGWINCH has
+ * been received. Relies on the signal handler installed by initialize_terminal().
+ * @return The Area (width and height) of the terminal screen.
+ * @throws std::runtime_error if ioctl fails.
+ */
+[[nodiscard]] auto cached_terminal_area() -> Area;
+
 }  // namespace esc
\ No newline at end of file
@@ -1,10 +1,119 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <unordered_map>
 
 namespace esc {
 
+/**
+ * A compiled terminfo entry, read from the terminfo database on disk.
+ * @details The file is memory mapped and left in its compiled form, a capability is
+ * read from the mapping when it is looked up. Both the legacy format, with 16 bit
+ * numbers, and the ncurses extended number format, with 32 bit numbers, are read, as
+ * well as the extended capabilities section, for user defined names like Tc or Smulx.
+ * Capabilities are looked up by their short terminfo name, like "colors" or "setaf".
+ * @see term(5)
+ */
+class Terminfo {
+   public:
+    /**
+     * Map and parse the header of the compiled terminfo file at \p path.
+     * @param path The path of the compiled terminfo file.
+     * @return The Terminfo, or std::nullopt if the file cannot be read or is not a
+     * compiled terminfo file.
+     */
+    [[nodiscard]] static auto open(std::string const& path) -> std::optional<Terminfo>;
+
+   public:
+    Terminfo(Terminfo&& other) noexcept;
+    auto operator=(Terminfo&& other) noexcept -> Terminfo&;
+
+    Terminfo(Terminfo const&) = delete;
+    auto operator=(Terminfo const&) -> Terminfo& = delete;
+
+    /**
+     * Unmaps the file.
+     */
+    ~Terminfo();
+
+   public:
+    /**
+     * Return the names section, the terminal names separated by '|'.
+     */
+    [[nodiscard]] auto names() const -> std::string_view { return names_; }
+
+    /**
+     * Return true if the boolean capability \p capname is present.
+     * @param capname The short name of the capability, like "am".
+     */
+    [[nodiscard]] auto flag(std::string_view capname) const -> bool;
+
+    /**
+     * Return the value of the numeric capability \p capname.
+     * @param capname The short name of the capability, like "colors".
+     * @return The value, or std::nullopt if absent or cancelled.
+     */
+    [[nodiscard]] auto number(std::string_view capname) const -> std::optional<int>;
+
+    /**
+     * Return the value of the string capability \p capname.
+     * @details Parameters are not expanded, the string is as stored in the file. It
+     * points into the mapped file and is valid for the lifetime of this object.
+     * @param capname The short name of the capability, like "setaf".
+     * @return The value, or std::nullopt if absent or cancelled.
+     */
+    [[nodiscard]] auto string(std::string_view capname) const
+        -> std::optional<std::string_view>;
+
+   private:
+    /**
+     * Where the values of the standard or the extended capabilities are.
+     */
+    struct Section {
+        char const* flags = nullptr;
+        char const* numbers = nullptr;
+        char const* offsets = nullptr;
+        char const* table = nullptr;
+        std::size_t flag_count = 0;
+        std::size_t number_count = 0;
+        std::size_t string_count = 0;
+        std::size_t table_size = 0;
+    };
+
+    char const* data_ = nullptr;
+    std::size_t size_ = 0;
+    std::size_t number_size_ = 2;
+    std::string_view names_;
+    Section standard_;
+    Section extended_;
+
+    /**
+     * Extended capability name to its index in flags, then numbers, then strings.
+     */
+    std::unordered_map<std::string_view, std::size_t> extended_names_;
+
+   private:
+    Terminfo(char const* data, std::size_t size) : data_{data}, size_{size} {}
+
+    /**
+     * Read the sections after the header, return false if the file is malformed.
+     */
+    [[nodiscard]] auto parse() -> bool;
+
+    [[nodiscard]] auto read_flag(Section const& section, std::size_t index) const
+        -> bool;
+
+    [[nodiscard]] auto read_number(Section const& section, std::size_t index) const
+        -> std::optional<int>;
+
+    [[nodiscard]] auto read_string(Section const& section, std::size_t index) const
+        -> std::optional<std::string_view>;
+};
+
 /**
  * Return the TERM environment variable from app startup.
  * @details This is the terminal type that the app was started in. This is used to look
@@ -13,10 +122,23 @@ namespace esc {
  */
 [[nodiscard]] auto TERM_var() -> std::string_view;
 
+/**
+ * Return the compiled terminfo entry for \p term_name from the terminfo database.
+ * @details Looks in $TERMINFO, ~/.terminfo, each directory in $TERMINFO_DIRS, then
+ * /etc/terminfo, /lib/terminfo and /usr/share/terminfo. The result, found or not, is
+ * cached for the life of the process, so later calls are a hash table lookup.
+ * @param term_name The terminal name, like "xterm-256color".
+ * @return The entry, or nullptr if there is no readable entry for \p term_name.
+ */
+[[nodiscard]] auto load_terminfo(std::string_view term_name = TERM_var())
+    -> Terminfo const*;
+
 /**
  * Return the number of colors in the terminal's color palette.
  * @details This is the number of possible XColor values that will work with the current
- * terminal emulator. This is looked up with the TERM env variable via the terminfo db.
+ * terminal emulator. This is the colors capability from load_terminfo(), or if there
+ * is no terminfo entry for TERM, from a small built in database. Clamped to 256, and
+ * 8 if TERM is not known to either.
  * It is not always accurate, as some terminals are capable of displaying more colors
  * than they report; this should be seen as a lower bound.
  * @return The number of colors in the terminal's color palette.
@@ -26,7 +148,9 @@ namespace esc {
 /**
  * Return true if terminal has support for true colors.
  * @details If true, applications can use the color setting functions with TrueColor.
- * True color support is determined by the COLORTERM environment variable.
+ * True color support is determined by the COLORTERM environment variable, the RGB or
+ * Tc capability reported by the terminal to probe_capabilities() or found in its
+ * terminfo entry, or failing those, a couple of known TERM names.
  * @return True if the terminal has support for true colors.
  * @see https://github.com/termstandard/colors
  */
@@ -0,0 +1,203 @@
+#include <esc/async.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <exception>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <esc/event.hpp>
+#include <esc/io.hpp>
+
+namespace esc {
+
+// Task --------------------------------------------------------------------------------
+
+Task::promise_type::~promise_type()
+{
+    if (scheduler != nullptr) {
+        --scheduler->task_count_;
+    }
+}
+
+auto Task::promise_type::get_return_object() -> Task
+{
+    return Task{Handle::from_promise(*this)};
+}
+
+void Task::promise_type::unhandled_exception()
+{
+    if (scheduler != nullptr && scheduler->exception_ == nullptr) {
+        scheduler->exception_ = std::current_exception();
+    }
+}
+
+Task::Task(Task&& other) noexcept : handle_{std::exchange(other.handle_, {})} {}
+
+auto Task::operator=(Task&& other) noexcept -> Task&
+{
+    if (this != &other) {
+        if (handle_) {
+            handle_.destroy();
+        }
+        handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+}
+
+Task::~Task()
+{
+    if (handle_) {
+        handle_.destroy();
+    }
+}
+
+// Awaitables --------------------------------------------------------------------------
+
+namespace detail {
+
+auto ReadAwaitable::await_suspend(Task::Handle handle) -> bool
+{
+    auto& scheduler = *handle.promise().scheduler;
+    if (scheduler.input_waiters_.empty() && !scheduler.pending_.empty()) {
+        event = scheduler.pending_.front();
+        scheduler.pending_.pop_front();
+        return false;
+    }
+    scheduler.input_waiters_.push_back({handle, &event, nullptr});
+    return true;
+}
+
+auto EventsAwaitable::await_suspend(Task::Handle handle) -> bool
+{
+    auto& scheduler = *handle.promise().scheduler;
+    out->clear();
+    if (scheduler.input_waiters_.empty() && !scheduler.pending_.empty()) {
+        out->assign(scheduler.pending_.begin(), scheduler.pending_.end());
+        scheduler.pending_.clear();
+        return false;
+    }
+    scheduler.input_waiters_.push_back({handle, nullptr, out});
+    return true;
+}
+
+void SleepAwaitable::await_suspend(Task::Handle handle)
+{
+    auto& scheduler = *handle.promise().scheduler;
+    scheduler.timers_.push({Scheduler::Clock::now() + duration, handle});
+}
+
+}  // namespace detail
+
+// Scheduler ---------------------------------------------------------------------------
+
+Scheduler::~Scheduler()
+{
+    for (auto const handle : ready_) {
+        handle.destroy();
+    }
+    for (auto const& waiter : input_waiters_) {
+        waiter.handle.destroy();
+    }
+    while (!timers_.empty()) {
+        timers_.top().handle.destroy();
+        timers_.pop();
+    }
+}
+
+void Scheduler::spawn(Task task)
+{
+    auto const handle = std::exchange(task.handle_, {});
+    handle.promise().scheduler = this;
+    ++task_count_;
+    ready_.push_back(handle);
+}
+
+void Scheduler::run()
+{
+    while (task_count_ > 0) {
+        while (!ready_.empty()) {
+            auto const handle = ready_.front();
+            ready_.pop_front();
+            handle.resume();
+            if (exception_ != nullptr) {
+                std::rethrow_exception(std::exchange(exception_, nullptr));
+            }
+        }
+        this->deliver_input();
+        if (!ready_.empty() || task_count_ == 0) {
+            continue;
+        }
+
+        auto const timeout = this->next_timeout();
+        if (!input_waiters_.empty()) {
+            if (read_events(batch_, timeout) > 0) {
+                pending_.insert(pending_.end(), batch_.begin(), batch_.end());
+            }
+        }
+        else if (!timers_.empty()) {
+            std::this_thread::sleep_until(timers_.top().when);
+        }
+        else {
+            throw std::logic_error{
+                "Scheduler::run(): Tasks are suspended with nothing to wake them."};
+        }
+        this->wake_timers();
+    }
+}
+
+void Scheduler::deliver_input()
+{
+    while (!pending_.empty() && !input_waiters_.empty()) {
+        auto const waiter = input_waiters_.front();
+        input_waiters_.pop_front();
+        if (waiter.event != nullptr) {
+            *waiter.event = pending_.front();
+            pending_.pop_front();
+        }
+        else {
+            waiter.events->assign(pending_.begin(), pending_.end());
+            pending_.clear();
+        }
+        ready_.push_back(waiter.handle);
+    }
+}
+
+void Scheduler::wake_timers()
+{
+    auto const now = Clock::now();
+    while (!timers_.empty() && timers_.top().when <= now) {
+        ready_.push_back(timers_.top().handle);
+        timers_.pop();
+    }
+}
+
+auto Scheduler::next_timeout() const -> int
+{
+    if (timers_.empty()) {
+        return -1;
+    }
+    auto const remaining = std::chrono::ceil<std::chrono::milliseconds>(
+        timers_.top().when - Clock::now());
+    return static_cast<int>(std::max(remaining.count(), decltype(remaining)::rep{0}));
+}
+
+// Free Functions ----------------------------------------------------------------------
+
+auto async_read() -> detail::ReadAwaitable { return {}; }
+
+auto async_events(std::vector<Event>& out) -> detail::EventsAwaitable
+{
+    return {&out};
+}
+
+auto sleep_for(std::chrono::milliseconds duration) -> detail::SleepAwaitable
+{
+    return {duration};
+}
+
+}  // namespace esc
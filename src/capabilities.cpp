@@ -0,0 +1,18 @@
+#include <esc/capabilities.hpp>
+
+#include <chrono>
+
+#include <esc/detail/query.hpp>
+
+namespace esc {
+
+auto probe_capabilities(std::chrono::milliseconds budget) -> Capabilities
+{
+    detail::probed_capabilities = detail::parse_probe_replies(
+        detail::query_terminal(detail::probe_request, static_cast<int>(budget.count())));
+    return detail::probed_capabilities;
+}
+
+auto capabilities() -> Capabilities const& { return detail::probed_capabilities; }
+
+}  // namespace esc
@@ -0,0 +1,322 @@
+#include <esc/detail/capability_cache.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <esc/capabilities.hpp>
+#include <esc/detail/lexer.hpp>
+#include <esc/detail/query.hpp>
+#include <esc/io.hpp>
+#include <esc/terminfo.hpp>
+
+namespace {
+
+/**
+ * The layout of a cache file, it holds exactly one Record.
+ */
+struct Record {
+    static constexpr auto max_attributes = std::size_t{16};
+    static constexpr auto max_version = std::size_t{128};
+
+    std::array<char, 8> magic;
+    std::uint32_t flags;
+    std::int32_t terminal_id;       // -1 if absent.
+    std::int32_t firmware_version;  // -1 if absent.
+    std::int32_t colors;            // -1 if absent.
+    std::uint32_t attribute_count;
+    std::array<std::int32_t, max_attributes> device_attributes;
+    std::uint32_t version_size;
+    std::array<char, max_version> version;
+};
+
+static_assert(std::is_trivially_copyable_v<Record>);
+
+/**
+ * Change the last byte when the Record layout changes.
+ */
+constexpr auto record_magic =
+    std::array<char, 8>{'e', 's', 'c', 'c', 'a', 'p', 's', '1'};
+
+constexpr auto replied_flag = std::uint32_t{1} << 0;
+constexpr auto synchronized_output_flag = std::uint32_t{1} << 1;
+constexpr auto bracketed_paste_flag = std::uint32_t{1} << 2;
+constexpr auto sgr_mouse_flag = std::uint32_t{1} << 3;
+constexpr auto sgr_pixel_mouse_flag = std::uint32_t{1} << 4;
+constexpr auto true_color_flag = std::uint32_t{1} << 5;
+
+/**
+ * A record of a probe that timed out is used for this long, then probed again.
+ */
+constexpr auto timeout_lifetime = std::chrono::hours{1};
+
+/**
+ * A record of the replies is used for this long, then probed again. Revalidation
+ * rewrites the record, so this only expires in sessions that never revalidate.
+ */
+constexpr auto replied_lifetime = std::chrono::hours{24 * 7};
+
+/**
+ * Set while probe replies are expected from the input stream.
+ */
+auto revalidating = false;
+auto revalidate_path = std::string{};
+auto revalidate_replies = std::string{};
+
+/**
+ * Return the value of the given environment variable, or an empty string.
+ */
+[[nodiscard]] auto get_env(char const* name) -> std::string
+{
+    char const* const v = std::getenv(name);
+    return v == nullptr ? "" : v;
+}
+
+/**
+ * 64 bit FNV-1a hash of \p bytes.
+ */
+[[nodiscard]] auto fnv1a(std::string_view bytes) -> std::uint64_t
+{
+    auto hash = std::uint64_t{0xcbf29ce484222325};
+    for (auto const c : bytes) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return hash;
+}
+
+[[nodiscard]] auto to_record(esc::Capabilities const& caps) -> Record
+{
+    auto record = Record{};
+    record.magic = record_magic;
+    record.flags = (caps.replied ? replied_flag : 0) |
+                   (caps.synchronized_output ? synchronized_output_flag : 0) |
+                   (caps.bracketed_paste ? bracketed_paste_flag : 0) |
+                   (caps.sgr_mouse ? sgr_mouse_flag : 0) |
+                   (caps.sgr_pixel_mouse ? sgr_pixel_mouse_flag : 0) |
+                   (caps.true_color ? true_color_flag : 0);
+    record.terminal_id = caps.terminal_id.value_or(-1);
+    record.firmware_version = caps.firmware_version.value_or(-1);
+    record.colors = caps.colors.value_or(-1);
+    record.attribute_count = static_cast<std::uint32_t>(
+        std::min(caps.device_attributes.size(), Record::max_attributes));
+    std::copy_n(caps.device_attributes.begin(), record.attribute_count,
+                record.device_attributes.begin());
+    record.version_size =
+        static_cast<std::uint32_t>(std::min(caps.version.size(), Record::max_version));
+    std::copy_n(caps.version.begin(), record.version_size, record.version.begin());
+    return record;
+}
+
+[[nodiscard]] auto from_record(Record const& record) -> std::optional<esc::Capabilities>
+{
+    if (record.magic != record_magic ||
+        record.attribute_count > Record::max_attributes ||
+        record.version_size > Record::max_version) {
+        return std::nullopt;
+    }
+    auto const optional = [](std::int32_t value) {
+        return value < 0 ? std::nullopt : std::optional<int>{value};
+    };
+    auto caps = esc::Capabilities{};
+    caps.replied = (record.flags & replied_flag) != 0;
+    caps.device_attributes.assign(
+        record.device_attributes.begin(),
+        record.device_attributes.begin() + record.attribute_count);
+    caps.terminal_id = optional(record.terminal_id);
+    caps.firmware_version = optional(record.firmware_version);
+    caps.version.assign(record.version.data(), record.version_size);
+    caps.synchronized_output = (record.flags & synchronized_output_flag) != 0;
+    caps.bracketed_paste = (record.flags & bracketed_paste_flag) != 0;
+    caps.sgr_mouse = (record.flags & sgr_mouse_flag) != 0;
+    caps.sgr_pixel_mouse = (record.flags & sgr_pixel_mouse_flag) != 0;
+    caps.true_color = (record.flags & true_color_flag) != 0;
+    caps.colors = optional(record.colors);
+    return caps;
+}
+
+/**
+ * Return true if the file at \p path was written within \p lifetime.
+ */
+[[nodiscard]] auto is_fresh(std::string const& path, std::chrono::seconds lifetime)
+    -> bool
+{
+    struct ::stat status = {};
+    if (::stat(path.c_str(), &status) != 0) {
+        return false;
+    }
+    auto const age = std::chrono::seconds{std::time(nullptr) - status.st_mtime};
+    return age < lifetime;
+}
+
+}  // namespace
+
+namespace esc::detail {
+
+auto capability_cache_path() -> std::string
+{
+    auto dir = get_env("XDG_CACHE_HOME");
+    if (dir.empty()) {
+        auto const home = get_env("HOME");
+        if (home.empty()) {
+            return "";
+        }
+        dir = home + "/.cache";
+    }
+    auto key = std::string{TERM_var()};
+    key.append(1, '\0').append(get_env("TERM_PROGRAM"));
+    key.append(1, '\0').append(get_env("TERM_PROGRAM_VERSION"));
+
+    auto name = std::array<char, 17>{};
+    std::snprintf(name.data(), name.size(), "%016llx",
+                  static_cast<unsigned long long>(::fnv1a(key)));
+    return dir + "/escape/" + name.data();
+}
+
+auto load_capabilities(std::string const& path) -> std::optional<Capabilities>
+{
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    struct ::stat status = {};
+    auto const is_record = ::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) &&
+                           static_cast<std::size_t>(status.st_size) == sizeof(Record);
+    auto* const map =
+        is_record ? ::mmap(nullptr, sizeof(Record), PROT_READ, MAP_PRIVATE, fd, 0)
+                  : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return std::nullopt;
+    }
+    auto record = Record{};
+    std::memcpy(&record, map, sizeof(Record));
+    ::munmap(map, sizeof(Record));
+    return ::from_record(record);
+}
+
+void store_capabilities(std::string const& path, Capabilities const& caps)
+{
+    auto error = std::error_code{};
+    std::filesystem::create_directories(std::filesystem::path{path}.parent_path(),
+                                        error);
+    if (error) {
+        return;
+    }
+    auto const temp = path + '.' + std::to_string(::getpid());
+    auto const fd =
+        ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    auto const record = ::to_record(caps);
+    auto const written = ::write(fd, &record, sizeof(record));
+    ::close(fd);
+    if (written != static_cast<::ssize_t>(sizeof(record)) ||
+        std::rename(temp.c_str(), path.c_str()) != 0) {
+        ::unlink(temp.c_str());
+    }
+}
+
+auto cached_capabilities(std::chrono::milliseconds budget, bool revalidate)
+    -> Capabilities
+{
+    if (::isatty(STDIN_FILENO) == 0 || ::isatty(STDOUT_FILENO) == 0) {
+        return {};
+    }
+    auto path = capability_cache_path();
+    auto cached = path.empty() ? std::nullopt : load_capabilities(path);
+    if (cached.has_value() &&
+        !::is_fresh(path, cached->replied ? replied_lifetime : timeout_lifetime)) {
+        cached = std::nullopt;
+    }
+    if (!revalidate) {
+        if (cached.has_value()) {
+            return *cached;
+        }
+        // Replies can not be left to arrive later, they would be echoed. Typeahead
+        // read by the query is passed on to read().
+        auto const caps = probe_capabilities(budget);
+        if (!path.empty()) {
+            store_capabilities(path, caps);
+        }
+        return caps;
+    }
+
+    probed_capabilities = cached.value_or(Capabilities{});
+    expect_probe_replies(path);
+    write(probe_request);
+    write("\033[c");  // Primary Device Attributes
+    flush();
+    if (!cached.has_value()) {
+        drain_probe_replies(budget);
+        if (is_expecting_probe_replies() && !path.empty()) {
+            store_capabilities(path, Capabilities{});  // The replies can still arrive.
+        }
+    }
+    return probed_capabilities;
+}
+
+auto is_expecting_probe_replies() -> bool { return revalidating; }
+
+void expect_probe_replies(std::string cache_path)
+{
+    revalidating = true;
+    revalidate_path = std::move(cache_path);
+    revalidate_replies.clear();
+}
+
+auto take_probe_reply(Token const& token) -> bool
+{
+    auto const& bytes = token.bytes;
+    auto const is_da1 = token.kind == TokenKind::CSI && bytes.starts_with('?') &&
+                        bytes.ends_with('c');
+    auto const is_csi_reply =
+        token.kind == TokenKind::CSI &&
+        (is_da1 || (bytes.starts_with('>') && bytes.ends_with('c')) ||
+         bytes.ends_with("$y"));
+    auto const is_dcs_reply =
+        token.kind == TokenKind::DCS &&
+        (bytes.starts_with(">|") || (bytes.size() >= 3 && bytes.substr(1, 2) == "+r"));
+    if (!is_csi_reply && !is_dcs_reply) {
+        return false;
+    }
+    if (!revalidating) {
+        return true;
+    }
+
+    if (is_csi_reply) {
+        revalidate_replies.append("\033[").append(bytes);
+    }
+    else {
+        revalidate_replies.append("\033P").append(bytes).append("\033\\");
+    }
+    if (is_da1) {
+        auto const caps = parse_probe_replies(revalidate_replies);
+        revalidating = false;
+        revalidate_replies.clear();
+        probed_capabilities = caps;
+        if (!revalidate_path.empty()) {
+            store_capabilities(revalidate_path, caps);  // Also renews its age.
+        }
+    }
+    return true;
+}
+
+}  // namespace esc::detail
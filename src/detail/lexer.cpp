@@ -0,0 +1,335 @@
+#include <esc/detail/lexer.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace {
+
+using esc::detail::Lexer;
+using esc::detail::Token;
+using esc::detail::TokenKind;
+using State = Lexer::State;
+
+/**
+ * Bytes that are handled the same way in every State.
+ */
+enum class ByteClass : std::uint8_t {
+    C0,            // C0 controls not listed below.
+    BEL,           // 0x07, ends an OSC string.
+    CancelByte,    // CAN and SUB, cancel a sequence.
+    ESC,           // 0x1B
+    Intermediate,  // 0x20 - 0x2F
+    Parameter,     // 0x30 - 0x3F
+    CSIIntro,      // '['
+    OSCIntro,      // ']'
+    DCSIntro,      // 'P'
+    SS3Intro,      // 'O'
+    APCIntro,      // '_'
+    SOSPMIntro,    // 'X' and '^'
+    Backslash,     // '\', the final byte of ST.
+    Final,         // Every other byte in 0x40 - 0x7E.
+    DEL,           // 0x7F
+    Continuation,  // 0x80 - 0xBF
+    Lead2,         // 0xC2 - 0xDF
+    Lead3,         // 0xE0 - 0xEF
+    Lead4,         // 0xF0 - 0xF4
+    Invalid,       // 0xC0, 0xC1 and 0xF5 - 0xFF, never in UTF-8.
+    Count,
+};
+
+enum class Action : std::uint8_t {
+    Ignore,
+    EmitByte,         // Emit the byte as a Text Token.
+    EmitPartial,      // Emit the collected bytes as Text, reprocess in Ground.
+    StartUTF8,        // Collect a UTF-8 lead byte.
+    ContinueUTF8,     // Collect a continuation byte, emit Text when complete.
+    EnterEscape,      // Drop anything collected.
+    EmitEscaped,      // Emit ESC + byte.
+    EnterCSI,         // Start collecting a CSI sequence.
+    EnterSS3,         // Start collecting an SS3 sequence.
+    EnterOSC,         // Start collecting a string.
+    EnterDCS,         //
+    EnterAPC,         //
+    EnterSOSPM,       // Start a string that is dropped.
+    Collect,          // Collect the byte.
+    EmitSequence,     // Collect the final byte and emit CSI or SS3.
+    StringBEL,        // Emit an OSC string, other strings collect BEL.
+    EmitString,       // Emit the string, on ST.
+    EscapeReprocess,  // Abort the string, reprocess as the byte after an ESC.
+    Cancel,           // Drop anything collected, back to Ground.
+};
+
+struct Transition {
+    State next;
+    Action action;
+};
+
+auto constexpr state_count = 7;
+auto constexpr class_count = static_cast<std::size_t>(ByteClass::Count);
+
+using Row = std::array<Transition, class_count>;
+
+/**
+ * Map each byte to its ByteClass.
+ */
+constexpr auto byte_classes = [] {
+    auto table = std::array<ByteClass, 256>{};
+    for (auto i = 0; i < 256; ++i) {
+        auto& x = table[static_cast<std::size_t>(i)];
+        if (i < 0x20) {
+            x = ByteClass::C0;
+        }
+        else if (i < 0x30) {
+            x = ByteClass::Intermediate;
+        }
+        else if (i < 0x40) {
+            x = ByteClass::Parameter;
+        }
+        else if (i < 0x7F) {
+            x = ByteClass::Final;
+        }
+        else if (i == 0x7F) {
+            x = ByteClass::DEL;
+        }
+        else if (i < 0xC0) {
+            x = ByteClass::Continuation;
+        }
+        else if (i < 0xC2) {
+            x = ByteClass::Invalid;
+        }
+        else if (i < 0xE0) {
+            x = ByteClass::Lead2;
+        }
+        else if (i < 0xF0) {
+            x = ByteClass::Lead3;
+        }
+        else if (i < 0xF5) {
+            x = ByteClass::Lead4;
+        }
+        else {
+            x = ByteClass::Invalid;
+        }
+    }
+    table[0x07] = ByteClass::BEL;
+    table[0x18] = ByteClass::CancelByte;
+    table[0x1A] = ByteClass::CancelByte;
+    table[0x1B] = ByteClass::ESC;
+    table['['] = ByteClass::CSIIntro;
+    table[']'] = ByteClass::OSCIntro;
+    table['P'] = ByteClass::DCSIntro;
+    table['O'] = ByteClass::SS3Intro;
+    table['_'] = ByteClass::APCIntro;
+    table['X'] = ByteClass::SOSPMIntro;
+    table['^'] = ByteClass::SOSPMIntro;
+    table['\\'] = ByteClass::Backslash;
+    return table;
+}();
+
+/**
+ * Return a Row where every ByteClass has the same Transition.
+ */
+[[nodiscard]] constexpr auto fill_row(Transition t) -> Row
+{
+    auto row = Row{};
+    row.fill(t);
+    return row;
+}
+
+/**
+ * Set the Transition for every ByteClass in 0x40 - 0x7E.
+ */
+constexpr void set_finals(Row& row, Transition t)
+{
+    for (auto c : {ByteClass::CSIIntro, ByteClass::OSCIntro, ByteClass::DCSIntro,
+                   ByteClass::SS3Intro, ByteClass::APCIntro, ByteClass::SOSPMIntro,
+                   ByteClass::Backslash, ByteClass::Final}) {
+        row[static_cast<std::size_t>(c)] = t;
+    }
+}
+
+constexpr void set(Row& row, ByteClass c, Transition t)
+{
+    row[static_cast<std::size_t>(c)] = t;
+}
+
+/**
+ * The Transition for each State and ByteClass.
+ */
+constexpr auto transitions = [] {
+    auto table = std::array<Row, state_count>{};
+
+    // Every byte is a Token of its own, except ESC and UTF-8 sequences.
+    auto& ground = table[static_cast<std::size_t>(State::Ground)];
+    ground = fill_row({State::Ground, Action::EmitByte});
+    set(ground, ByteClass::ESC, {State::Escape, Action::EnterEscape});
+    set(ground, ByteClass::Lead2, {State::UTF8, Action::StartUTF8});
+    set(ground, ByteClass::Lead3, {State::UTF8, Action::StartUTF8});
+    set(ground, ByteClass::Lead4, {State::UTF8, Action::StartUTF8});
+
+    auto& escape = table[static_cast<std::size_t>(State::Escape)];
+    escape = fill_row({State::Ground, Action::EmitEscaped});
+    set(escape, ByteClass::CancelByte, {State::Ground, Action::Cancel});
+    set(escape, ByteClass::CSIIntro, {State::CSI, Action::EnterCSI});
+    set(escape, ByteClass::SS3Intro, {State::SS3, Action::EnterSS3});
+    set(escape, ByteClass::OSCIntro, {State::String, Action::EnterOSC});
+    set(escape, ByteClass::DCSIntro, {State::String, Action::EnterDCS});
+    set(escape, ByteClass::APCIntro, {State::String, Action::EnterAPC});
+    set(escape, ByteClass::SOSPMIntro, {State::String, Action::EnterSOSPM});
+
+    // C0 controls are executed by a terminal, there is nothing to execute here.
+    for (auto state : {State::CSI, State::SS3}) {
+        auto& row = table[static_cast<std::size_t>(state)];
+        row = fill_row({state, Action::Ignore});
+        set(row, ByteClass::Parameter, {state, Action::Collect});
+        set(row, ByteClass::Intermediate, {state, Action::Collect});
+        set_finals(row, {State::Ground, Action::EmitSequence});
+        set(row, ByteClass::ESC, {State::Escape, Action::EnterEscape});
+        set(row, ByteClass::CancelByte, {State::Ground, Action::Cancel});
+    }
+
+    auto& string = table[static_cast<std::size_t>(State::String)];
+    string = fill_row({State::String, Action::Collect});
+    set(string, ByteClass::BEL, {State::String, Action::StringBEL});
+    set(string, ByteClass::ESC, {State::StringEscape, Action::Ignore});
+    set(string, ByteClass::CancelByte, {State::Ground, Action::Cancel});
+
+    auto& string_escape = table[static_cast<std::size_t>(State::StringEscape)];
+    string_escape = fill_row({State::Escape, Action::EscapeReprocess});
+    set(string_escape, ByteClass::Backslash, {State::Ground, Action::EmitString});
+
+    auto& utf8 = table[static_cast<std::size_t>(State::UTF8)];
+    utf8 = fill_row({State::Ground, Action::EmitPartial});
+    set(utf8, ByteClass::Continuation, {State::UTF8, Action::ContinueUTF8});
+
+    return table;
+}();
+
+/**
+ * Return the number of continuation bytes after the UTF-8 lead byte \p c.
+ */
+[[nodiscard]] auto continuation_count(unsigned char c) -> std::uint8_t
+{
+    switch (byte_classes[c]) {
+        case ByteClass::Lead2: return 1;
+        case ByteClass::Lead3: return 2;
+        default: return 3;
+    }
+}
+
+}  // namespace
+
+namespace esc::detail {
+
+auto Lexer::next(std::span<char const>& input) -> std::optional<Token>
+{
+    while (!input.empty()) {
+        auto const c = input.front();
+        auto const byte = static_cast<unsigned char>(c);
+        auto const from = state_;
+        auto const t = ::transitions[static_cast<std::size_t>(from)]
+                                    [static_cast<std::size_t>(::byte_classes[byte])];
+        state_ = t.next;
+
+        // These leave the byte in input, it is processed again in the next State.
+        if (t.action == Action::EmitPartial) {
+            return Token{TokenKind::Text, bytes_};
+        }
+        if (t.action == Action::EscapeReprocess) {
+            bytes_.clear();
+            continue;
+        }
+        input = input.subspan(1);
+
+        switch (t.action) {
+            case Action::Ignore: break;
+            case Action::EmitByte:
+                bytes_.assign(1, c);
+                return Token{TokenKind::Text, bytes_};
+            case Action::StartUTF8:
+                bytes_.assign(1, c);
+                utf8_remaining_ = ::continuation_count(byte);
+                break;
+            case Action::ContinueUTF8:
+                bytes_.push_back(c);
+                if (--utf8_remaining_ == 0) {
+                    state_ = State::Ground;
+                    return Token{TokenKind::Text, bytes_};
+                }
+                break;
+            case Action::EmitEscaped:
+                bytes_.assign(1, c);
+                return Token{TokenKind::Escaped, bytes_};
+            case Action::EnterOSC:
+            case Action::EnterDCS:
+            case Action::EnterAPC:
+            case Action::EnterSOSPM:
+                bytes_.clear();
+                intro_ = c;
+                string_kind_ = t.action == Action::EnterOSC   ? TokenKind::OSC
+                               : t.action == Action::EnterDCS ? TokenKind::DCS
+                                                              : TokenKind::APC;
+                drop_string_ = t.action == Action::EnterSOSPM;
+                break;
+            case Action::Collect: this->collect(c); break;
+            case Action::EmitSequence:
+                this->collect(c);
+                return Token{from == State::CSI ? TokenKind::CSI : TokenKind::SS3,
+                             bytes_};
+            case Action::StringBEL:
+                if (string_kind_ != TokenKind::OSC) {
+                    this->collect(c);
+                    break;
+                }
+                state_ = State::Ground;
+                [[fallthrough]];
+            case Action::EmitString:
+                if (drop_string_) {
+                    break;
+                }
+                return Token{string_kind_, bytes_};
+            case Action::EnterCSI:
+            case Action::EnterSS3:
+                bytes_.clear();
+                intro_ = c;
+                break;
+            case Action::EnterEscape:
+            case Action::Cancel: bytes_.clear(); break;
+            case Action::EmitPartial:
+            case Action::EscapeReprocess: break;  // Handled above.
+        }
+    }
+    return std::nullopt;
+}
+
+auto Lexer::idle() -> std::optional<Token>
+{
+    switch (state_) {
+        case State::Escape:
+            state_ = State::Ground;
+            bytes_.assign(1, '\033');
+            return Token{TokenKind::Text, bytes_};
+        // Also how Alt + [ and friends are read.
+        case State::CSI:
+        case State::SS3:
+        case State::String:
+            if (!bytes_.empty()) {
+                return std::nullopt;
+            }
+            bytes_.assign(1, intro_);
+            state_ = State::Ground;
+            return Token{TokenKind::Escaped, bytes_};
+        default: return std::nullopt;
+    }
+}
+
+void Lexer::collect(char c)
+{
+    if (bytes_.size() < max_token_size) {
+        bytes_.push_back(c);
+    }
+}
+
+}  // namespace esc::detail
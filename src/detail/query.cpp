@@ -0,0 +1,242 @@
+#include <esc/detail/query.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <esc/capabilities.hpp>
+#include <esc/detail/lexer.hpp>
+#include <esc/io.hpp>
+
+namespace {
+
+/**
+ * Return true if \p c is a decimal digit.
+ */
+[[nodiscard]] auto is_digit(char c) -> bool { return c >= '0' && c <= '9'; }
+
+/**
+ * Return true if \p token is a Primary Device Attributes reply, CSI ? Ps ; ... c
+ */
+[[nodiscard]] auto is_da1_reply(esc::detail::Token const& token) -> bool
+{
+    return token.kind == esc::detail::TokenKind::CSI && token.bytes.starts_with('?') &&
+           token.bytes.ends_with('c');
+}
+
+/**
+ * Parse the ';' separated decimal parameters at the front of \p bytes.
+ * @details Stops at the first byte that is not a digit or ';'. An empty parameter is
+ * zero.
+ */
+[[nodiscard]] auto parse_params(std::string_view bytes) -> std::vector<int>
+{
+    constexpr auto max_value = 999'999;
+    auto params = std::vector<int>{};
+    auto value = 0;
+    for (auto const c : bytes) {
+        if (is_digit(c)) {
+            value = std::min(value * 10 + (c - '0'), max_value);
+        }
+        else if (c == ';') {
+            params.push_back(value);
+            value = 0;
+        }
+        else {
+            break;
+        }
+    }
+    params.push_back(value);
+    return params;
+}
+
+/**
+ * Decode a string of hex digit pairs.
+ * @return The decoded string, or std::nullopt if \p hex is not valid.
+ */
+[[nodiscard]] auto decode_hex(std::string_view hex) -> std::optional<std::string>
+{
+    if (hex.size() % 2 != 0) {
+        return std::nullopt;
+    }
+    auto result = std::string{};
+    for (auto i = std::size_t{0}; i < hex.size(); i += 2) {
+        auto byte = 0;
+        auto const [end, error] = std::from_chars(hex.data() + i, hex.data() + i + 2,
+                                                  byte, 16);
+        if (error != std::errc{} || end != hex.data() + i + 2) {
+            return std::nullopt;
+        }
+        result.push_back(static_cast<char>(byte));
+    }
+    return result;
+}
+
+/**
+ * Record a DA1, DA2 or DECRQM reply in \p caps.
+ * @param bytes The bytes of a CSI Token.
+ */
+void parse_csi_reply(std::string_view bytes, esc::Capabilities& caps)
+{
+    if (bytes.size() < 2) {
+        return;
+    }
+    if (bytes.front() == '?' && bytes.back() == 'c') {  // DA1
+        caps.replied = true;
+        caps.device_attributes = parse_params(bytes.substr(1));
+    }
+    else if (bytes.front() == '>' && bytes.back() == 'c') {  // DA2
+        auto const params = parse_params(bytes.substr(1));
+        if (params.size() >= 2) {
+            caps.terminal_id = params[0];
+            caps.firmware_version = params[1];
+        }
+    }
+    else if (bytes.front() == '?' && bytes.ends_with("$y")) {  // DECRQM
+        auto const params = parse_params(bytes.substr(1));
+        if (params.size() < 2) {
+            return;
+        }
+        // 0 not recognized, 1 set, 2 reset, 3 permanently set, 4 permanently reset.
+        auto const supported = params[1] >= 1 && params[1] <= 3;
+        switch (params[0]) {
+            case 2026: caps.synchronized_output = supported; break;
+            case 2004: caps.bracketed_paste = supported; break;
+            case 1006: caps.sgr_mouse = supported; break;
+            case 1016: caps.sgr_pixel_mouse = supported; break;
+            default: break;
+        }
+    }
+}
+
+/**
+ * Record an XTVERSION or XTGETTCAP reply in \p caps.
+ * @param bytes The bytes of a DCS Token.
+ */
+void parse_dcs_reply(std::string_view bytes, esc::Capabilities& caps)
+{
+    if (bytes.starts_with(">|")) {  // XTVERSION
+        caps.version = std::string{bytes.substr(2)};
+        return;
+    }
+    if (!bytes.starts_with("1+r")) {  // 0+r is an unknown capability.
+        return;
+    }
+    // XTGETTCAP, hex encoded name=value pairs separated by ';'.
+    auto rest = bytes.substr(3);
+    while (!rest.empty()) {
+        auto const end = rest.find(';');
+        auto const entry = rest.substr(0, end);
+        rest = end == std::string_view::npos ? "" : rest.substr(end + 1);
+
+        auto const equals = entry.find('=');
+        auto const name = decode_hex(entry.substr(0, equals));
+        auto const value = equals == std::string_view::npos
+                               ? std::optional<std::string>{""}
+                               : decode_hex(entry.substr(equals + 1));
+        if (!name.has_value() || !value.has_value()) {
+            continue;
+        }
+        if (*name == "RGB" || *name == "Tc") {
+            caps.true_color = true;
+        }
+        else if (*name == "colors" || *name == "Co") {
+            auto colors = 0;
+            auto const* const last = value->data() + value->size();
+            auto const [end_ptr, error] = std::from_chars(value->data(), last, colors);
+            if (error == std::errc{} && end_ptr == last) {
+                caps.colors = colors;
+            }
+        }
+    }
+}
+
+}  // namespace
+
+namespace esc::detail {
+
+auto query_terminal(std::string_view request, int timeout_ms) -> std::string
+{
+    if (::isatty(STDIN_FILENO) == 0 || ::isatty(STDOUT_FILENO) == 0) {
+        return "";
+    }
+
+    auto original = ::termios{};
+    ::tcgetattr(STDIN_FILENO, &original);
+    auto raw = original;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    ::tcsetattr(STDIN_FILENO, TCSANOW, &raw);
+
+    write(request);
+    write("\033[c");  // Primary Device Attributes
+    flush();
+
+    using Clock = std::chrono::steady_clock;
+    auto const deadline = Clock::now() + std::chrono::milliseconds{timeout_ms};
+    auto replies = std::string{};
+    auto buffer = std::array<char, 256>{};
+    auto lexer = Lexer{};
+    auto has_da1_reply = false;
+    while (!has_da1_reply) {
+        auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - Clock::now());
+        if (remaining.count() <= 0) {
+            break;
+        }
+        auto file = pollfd{STDIN_FILENO, POLLIN, 0};
+        auto const result = ::poll(&file, 1, static_cast<int>(remaining.count()));
+        if (result == -1 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        auto const count = ::read(STDIN_FILENO, buffer.data(), buffer.size());
+        if (count <= 0) {
+            break;
+        }
+        auto const size = static_cast<std::size_t>(count);
+        auto input = std::span<char const>{buffer.data(), size};
+        while (auto const token = lexer.next(input)) {
+            has_da1_reply = has_da1_reply || is_da1_reply(*token);
+        }
+        replies.append(buffer.data(), size);
+    }
+
+    ::tcsetattr(STDIN_FILENO, TCSANOW, &original);
+    feed_input(std::span<char const>{replies.data(), replies.size()});
+    return replies;
+}
+
+auto parse_probe_replies(std::string_view replies) -> Capabilities
+{
+    auto caps = Capabilities{};
+    auto lexer = Lexer{};
+    auto input = std::span<char const>{replies.data(), replies.size()};
+    while (auto const token = lexer.next(input)) {
+        if (token->kind == TokenKind::CSI) {
+            ::parse_csi_reply(token->bytes, caps);
+        }
+        else if (token->kind == TokenKind::DCS) {
+            ::parse_dcs_reply(token->bytes, caps);
+        }
+    }
+    return caps;
+}
+
+}  // namespace esc::detail
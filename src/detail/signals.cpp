@@ -1,9 +1,14 @@
 #include <esc/detail/signals.hpp>
 
+#include <array>
+#include <cerrno>
 #include <csignal>
 #include <cstdlib>
 #include <stdexcept>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <esc/terminal.hpp>
 
 namespace {
@@ -27,15 +32,50 @@ extern "C" auto sigint_handler(int sig) -> void
 }
 
 /**
- * Set the window_resize_sig flag to true on SIGWINCH signals.
+ * The read and write ends of the self-pipe that SIGWINCH is reported on.
+ */
+auto resize_pipe = std::array<int, 2>{-1, -1};
+
+/**
+ * Set the window_resize_sig flag to true on SIGWINCH signals, and wake up anything
+ * polling resize_fd().
  */
 extern "C" auto resize_handler(int sig) -> void
 {
     if (sig == SIGWINCH) {
         esc::detail::window_resize_sig = 1;
+        ++esc::detail::window_resize_count;
+        if (resize_pipe[1] != -1) {
+            auto const saved_errno = errno;
+            auto const byte = char{0};
+            (void)::write(resize_pipe[1], &byte, 1);  // Pipe full is still readable.
+            errno = saved_errno;
+        }
     }
 }
 
+/**
+ * Create resize_pipe, with both ends non-blocking and close-on-exec.
+ * @throws std::runtime_error if the pipe cannot be created.
+ */
+void open_resize_pipe()
+{
+    auto fds = std::array<int, 2>{};
+    if (::pipe(fds.data()) == -1) {
+        throw std::runtime_error{"open_resize_pipe(): pipe call"};
+    }
+    for (auto const fd : fds) {
+        auto const flags = ::fcntl(fd, F_GETFL);
+        if (flags == -1 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1 ||
+            ::fcntl(fd, F_SETFD, FD_CLOEXEC) == -1) {
+            ::close(fds[0]);
+            ::close(fds[1]);
+            throw std::runtime_error{"open_resize_pipe(): fcntl call"};
+        }
+    }
+    resize_pipe = fds;
+}
+
 }  // namespace
 
 namespace esc {
@@ -48,12 +88,18 @@ namespace esc::detail {
 
 std::sig_atomic_t window_resize_sig = 0;
 
+std::sig_atomic_t window_resize_count = 0;
+
 auto register_signals(bool sigint) -> void
 {
 #if !defined(__APPLE__) && !defined(__MACH__)
     std::at_quick_exit(::esc::uninitialize_terminal);
 #endif
 
+    if (resize_pipe[0] == -1) {
+        open_resize_pipe();
+    }
+
     if (std::signal(SIGWINCH, &resize_handler) == SIG_ERR) {
         throw std::runtime_error{"register_SIGWINCH(): std::signal call"};
     }
@@ -63,4 +109,14 @@ auto register_signals(bool sigint) -> void
     }
 }
 
+auto resize_fd() -> int { return resize_pipe[0]; }
+
+void drain_resize_fd()
+{
+    auto bytes = std::array<char, 64>{};
+    while (::read(resize_pipe[0], bytes.data(), bytes.size()) > 0) {
+        window_resize_sig = 1;
+    }
+}
+
 }  // namespace esc::detail
@@ -1,6 +1,8 @@
 #include <esc/detail/transcode.hpp>
 
+#include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
 #include <stdexcept>
 #include <string>
@@ -10,7 +12,284 @@
 #include <unicode/uchar.h>
 #include <unicode/unistr.h>
 
-#include <zzz/coro.hpp>
+#if defined(__SSE2__) || defined(_M_X64)
+#    include <emmintrin.h>
+#endif
+#if defined(__x86_64__) && defined(__GNUC__)
+#    include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * Encodes [first, last) as UTF-8 starting at out, returns one past the last byte.
+ */
+using Encoder = auto (*)(char32_t const* first, char32_t const* last, char* out)
+    -> char*;
+
+auto encode_scalar(char32_t const* first, char32_t const* last, char* out) -> char*
+{
+    for (; first != last; ++first) {
+        auto i = 0;
+        U8_APPEND_UNSAFE(out, i, static_cast<UChar32>(*first));  // ICU macro
+        out += i;
+    }
+    return out;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+/**
+ * Encode eight code points in [0x80, 0x7FF], packed into 16 bit lanes, as sixteen
+ * bytes of UTF-8.
+ */
+[[nodiscard]] auto two_byte_sse2(__m128i words) -> __m128i
+{
+    auto const lead = _mm_or_si128(_mm_srli_epi16(words, 6), _mm_set1_epi16(0xC0));
+    auto const tail = _mm_or_si128(_mm_and_si128(words, _mm_set1_epi16(0x3F)),
+                                   _mm_set1_epi16(0x80));
+    return _mm_or_si128(lead, _mm_slli_epi16(tail, 8));
+}
+
+/**
+ * Encode eight code points at a time while they are all ASCII or all two byte
+ * sequences, anything else is handed to encode_scalar() one block at a time.
+ */
+auto encode_sse2(char32_t const* first, char32_t const* last, char* out) -> char*
+{
+    auto const ascii_max = _mm_set1_epi32(0x7F);
+    auto const two_byte_max = _mm_set1_epi32(0x7FF);
+    while (last - first >= 8) {
+        auto const a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        auto const b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first + 4));
+
+        // Code points are at most 0x10FFFF, so the signed compares are safe and the
+        // OR of the block is only small if every code point is.
+        auto const any = _mm_or_si128(a, b);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi32(any, ascii_max)) == 0) {
+            auto const words = _mm_packs_epi32(a, b);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(out),
+                             _mm_packus_epi16(words, words));
+            first += 8;
+            out += 8;
+            continue;
+        }
+        auto const all_multi =
+            _mm_and_si128(_mm_cmpgt_epi32(a, ascii_max), _mm_cmpgt_epi32(b, ascii_max));
+        if (_mm_movemask_epi8(_mm_cmpgt_epi32(any, two_byte_max)) == 0 &&
+            _mm_movemask_epi8(all_multi) == 0xFFFF) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                             ::two_byte_sse2(_mm_packs_epi32(a, b)));
+            first += 8;
+            out += 16;
+            continue;
+        }
+        out = ::encode_scalar(first, first + 8, out);
+        first += 8;
+    }
+    return ::encode_scalar(first, last, out);
+}
+
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+/**
+ * AVX2 version of encode_sse2(), sixteen code points at a time.
+ */
+[[gnu::target("avx2")]]
+auto encode_avx2(char32_t const* first, char32_t const* last, char* out) -> char*
+{
+    auto const ascii_max = _mm256_set1_epi32(0x7F);
+    auto const not_ascii = _mm256_set1_epi32(~0x7F);
+    auto const not_two_byte = _mm256_set1_epi32(~0x7FF);
+    while (last - first >= 16) {
+        auto const a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+        auto const b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first + 8));
+        auto const any = _mm256_or_si256(a, b);
+
+        // packs works within 128 bit lanes, the permute puts the words back in order.
+        auto const words = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+        if (_mm256_testz_si256(any, not_ascii) != 0) {
+            auto const bytes = _mm256_permute4x64_epi64(
+                _mm256_packus_epi16(words, words), 0x08);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out),
+                             _mm256_castsi256_si128(bytes));
+            first += 16;
+            out += 16;
+            continue;
+        }
+        auto const all_multi = _mm256_and_si256(_mm256_cmpgt_epi32(a, ascii_max),
+                                                _mm256_cmpgt_epi32(b, ascii_max));
+        if (_mm256_testz_si256(any, not_two_byte) != 0 &&
+            _mm256_movemask_epi8(all_multi) == -1) {
+            auto const lead = _mm256_or_si256(_mm256_srli_epi16(words, 6),
+                                              _mm256_set1_epi16(0xC0));
+            auto const tail =
+                _mm256_or_si256(_mm256_and_si256(words, _mm256_set1_epi16(0x3F)),
+                                _mm256_set1_epi16(0x80));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+                                _mm256_or_si256(lead, _mm256_slli_epi16(tail, 8)));
+            first += 16;
+            out += 32;
+            continue;
+        }
+        out = ::encode_scalar(first, first + 16, out);
+        first += 16;
+    }
+    return ::encode_sse2(first, last, out);
+}
+
+#endif
+
+// DECODING ----------------------------------------------------------------------------
+
+/**
+ * Decodes [first, last) as UTF-32 starting at out, returns one past the last written.
+ */
+using Decoder = auto (*)(char const* first, char const* last, char32_t* out)
+    -> char32_t*;
+
+/**
+ * Decode the code point starting at \p first into \p out.
+ * @return One past the last byte of the code point.
+ * @throws std::runtime_error If the bytes are not a valid UTF-8 sequence.
+ */
+auto decode_one(char const* first, char const* last, char32_t* out) -> char const*
+{
+    auto const window =
+        static_cast<std::int32_t>(std::min<std::ptrdiff_t>(last - first, 4));
+    auto i = std::int32_t{0};
+    auto c = UChar32{0};
+    U8_NEXT(first, i, window, c);  // ICU macro, validates
+    if (c < 0) {
+        throw std::runtime_error{"Invalid UTF-8 sequence"};
+    }
+    *out = static_cast<char32_t>(c);
+    return first + i;
+}
+
+auto decode_scalar(char const* first, char const* last, char32_t* out) -> char32_t*
+{
+    while (first != last) {
+        first = ::decode_one(first, last, out++);
+    }
+    return out;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+
+/**
+ * Widen sixteen bytes at a time while they are all ASCII, code points that start in
+ * any other block are decoded and validated by decode_one().
+ */
+auto decode_sse2(char const* first, char const* last, char32_t* out) -> char32_t*
+{
+    auto const zero = _mm_setzero_si128();
+    while (last - first >= 16) {
+        auto const bytes = _mm_loadu_si128(reinterpret_cast<__m128i const*>(first));
+        if (_mm_movemask_epi8(bytes) == 0) {
+            auto const low = _mm_unpacklo_epi8(bytes, zero);
+            auto const high = _mm_unpackhi_epi8(bytes, zero);
+            auto* const dest = reinterpret_cast<__m128i*>(out);
+            _mm_storeu_si128(dest + 0, _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(dest + 1, _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(dest + 2, _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(dest + 3, _mm_unpackhi_epi16(high, zero));
+            first += 16;
+            out += 16;
+            continue;
+        }
+        auto const block_end = first + 16;
+        while (first < block_end) {
+            first = ::decode_one(first, last, out++);
+        }
+    }
+    return ::decode_scalar(first, last, out);
+}
+
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+/**
+ * AVX2 version of decode_sse2(), thirty-two bytes at a time.
+ */
+[[gnu::target("avx2")]]
+auto decode_avx2(char const* first, char const* last, char32_t* out) -> char32_t*
+{
+    while (last - first >= 32) {
+        auto const bytes = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(first));
+        if (_mm256_movemask_epi8(bytes) == 0) {
+            auto* const dest = reinterpret_cast<__m256i*>(out);
+            for (auto i = 0; i < 4; ++i) {
+                auto const eight =
+                    _mm_loadl_epi64(reinterpret_cast<__m128i const*>(first + i * 8));
+                _mm256_storeu_si256(dest + i, _mm256_cvtepu8_epi32(eight));
+            }
+            first += 32;
+            out += 32;
+            continue;
+        }
+        auto const block_end = first + 32;
+        while (first < block_end) {
+            first = ::decode_one(first, last, out++);
+        }
+    }
+    return ::decode_sse2(first, last, out);
+}
+
+#endif
+
+// DISPATCH ----------------------------------------------------------------------------
+
+/**
+ * Pick the fastest encoder the running CPU supports.
+ */
+[[nodiscard]] auto select_encoder() -> Encoder
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        return encode_avx2;
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    return encode_sse2;
+#else
+    return encode_scalar;
+#endif
+}
+
+[[nodiscard]] auto encoder() -> Encoder
+{
+    static auto const encode = ::select_encoder();
+    return encode;
+}
+
+/**
+ * Pick the fastest decoder the running CPU supports.
+ */
+[[nodiscard]] auto select_decoder() -> Decoder
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        return decode_avx2;
+    }
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+    return decode_sse2;
+#else
+    return decode_scalar;
+#endif
+}
+
+[[nodiscard]] auto decoder() -> Decoder
+{
+    static auto const decode = ::select_decoder();
+    return decode;
+}
+
+}  // namespace
 
 namespace esc::detail {
 
@@ -32,14 +311,17 @@ auto u32_to_u8(std::u32string_view sv) -> std::string
 void u32_to_u8(std::u32string_view sv, std::string& out)
 {
     out.clear();
-    out.reserve(sv.size());  // Common case every char is 1 byte.
+    u32_to_u8_append(sv, out);
+}
 
-    for (auto c : sv) {
-        char utf8_buffer[U8_MAX_LENGTH];
-        auto i = 0;
-        U8_APPEND_UNSAFE(utf8_buffer, i, static_cast<UChar32>(c));
-        out.append(utf8_buffer, i);
-    }
+void u32_to_u8_append(std::u32string_view sv, std::string& out)
+{
+    // Encode in place, the string is trimmed to the bytes used afterwards.
+    auto const begin = out.size();
+    out.resize(begin + sv.size() * U8_MAX_LENGTH);
+    auto const end =
+        ::encoder()(sv.data(), sv.data() + sv.size(), out.data() + begin);
+    out.resize(static_cast<std::size_t>(end - out.data()));
 }
 
 auto u8_to_u32(std::array<char, 4> bytes) -> char32_t
@@ -51,19 +333,6 @@ auto u8_to_u32(std::array<char, 4> bytes) -> char32_t
     return u_str.char32At(0);
 }
 
-auto u8_string_to_u32(std::string_view sv) -> zzz::Generator<char32_t>
-{
-    auto i = std::int32_t{0};  // Index in the UTF-8 string
-    auto const length = static_cast<std::int32_t>(sv.length());
-
-    while (i < length) {
-        UChar32 ch;
-        U8_NEXT(sv.data(), i, length, ch);
-        if (ch < 0) { throw std::runtime_error{"Invalid UTF-8 sequence"}; }
-        co_yield static_cast<char32_t>(ch);
-    }
-}
-
 [[nodiscard]]
 auto u8_string_to_u32_string(std::string_view sv) -> std::u32string
 {
@@ -74,17 +343,24 @@ auto u8_string_to_u32_string(std::string_view sv) -> std::u32string
 
 void u8_string_to_u32_string(std::string_view sv, std::u32string& out)
 {
-    auto i = std::int32_t{0};  // Index in the UTF-8 string
-    auto const length = static_cast<std::int32_t>(sv.length());
-
     out.clear();
-    out.reserve(sv.length());
-    while (i < length) {
-        UChar32 ch;
-        U8_NEXT(sv.data(), i, length, ch);
-        if (ch < 0) { throw std::runtime_error{"Invalid UTF-8 sequence"}; }
-        out.push_back(static_cast<char32_t>(ch));
+    u8_to_u32_append(sv, out);
+}
+
+void u8_to_u32_append(std::string_view sv, std::u32string& out)
+{
+    // Each byte decodes to at most one code point, trimmed to the count afterwards.
+    auto const begin = out.size();
+    out.resize(begin + sv.size());
+    try {
+        auto const end =
+            ::decoder()(sv.data(), sv.data() + sv.size(), out.data() + begin);
+        out.resize(static_cast<std::size_t>(end - out.data()));
+    }
+    catch (...) {
+        out.resize(begin);
+        throw;
     }
 }
 
-}  // namespace esc::detail
\ No newline at end of file
+}  // namespace esc::detail
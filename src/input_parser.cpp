@@ -0,0 +1,797 @@
+#include <esc/input_parser.hpp>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <variant>
+
+#include <unistd.h>
+
+#include <esc/detail/capability_cache.hpp>
+#include <esc/detail/lexer.hpp>
+#include <esc/detail/signals.hpp>
+#include <esc/detail/transcode.hpp>
+#include <esc/detail/tty_file.hpp>
+#include <esc/event.hpp>
+#include <esc/key.hpp>
+#include <esc/mouse.hpp>
+#include <esc/terminal.hpp>
+
+namespace {
+
+using esc::Key;
+constexpr auto keymap =
+    std::array<esc::Key, 128>{Key::Null,
+                              Key::Escape,
+                              Key::One,
+                              Key::Two,
+                              Key::Three,
+                              Key::Four,
+                              Key::Five,
+                              Key::Six,
+                              Key::Seven,
+                              Key::Eight,
+                              Key::Nine,
+                              Key::Zero,
+                              Key::Minus,
+                              Key::Equals,
+                              Key::Backspace,
+                              Key::Tab,
+                              Key::q,
+                              Key::w,
+                              Key::e,
+                              Key::r,
+                              Key::t,
+                              Key::y,
+                              Key::u,
+                              Key::i,
+                              Key::o,
+                              Key::p,
+                              Key::LeftBracket,
+                              Key::RightBracket,
+                              Key::Enter,
+                              Key::LCtrl,
+                              Key::a,
+                              Key::s,
+                              Key::d,
+                              Key::f,
+                              Key::g,
+                              Key::h,
+                              Key::j,
+                              Key::k,
+                              Key::l,
+                              Key::Semicolon,
+                              Key::Apostrophe,
+                              Key::Accent,
+                              Key::LShift,
+                              Key::Backslash,
+                              Key::z,
+                              Key::x,
+                              Key::c,
+                              Key::v,
+                              Key::b,
+                              Key::n,
+                              Key::m,
+                              Key::Comma,
+                              Key::Period,
+                              Key::ForwardSlash,
+                              Key::RShift,
+                              Key::KeypadAsterisk,
+                              Key::LAlt,
+                              Key::Space,
+                              Key::CapsLock,
+                              Key::Function1,
+                              Key::Function2,
+                              Key::Function3,
+                              Key::Function4,
+                              Key::Function5,
+                              Key::Function6,
+                              Key::Function7,
+                              Key::Function8,
+                              Key::Function9,
+                              Key::Function10,
+                              Key::NumLock,
+                              Key::ScrollLock,
+                              Key::Keypad7,
+                              Key::Keypad8,
+                              Key::Keypad9,
+                              Key::KeypadMinus,
+                              Key::Keypad4,
+                              Key::Keypad5,
+                              Key::Keypad6,
+                              Key::KeypadPlus,
+                              Key::Keypad1,
+                              Key::Keypad2,
+                              Key::Keypad3,
+                              Key::Keypad0,
+                              Key::KeypadPeriod,
+                              Key::AltSystemRequest,  // "magic SysRq key"
+                              Key::Null,              // Not commonly used.
+                              Key::Null,  // Unlabeled key on non-us keyboards
+                              Key::Function11,
+                              Key::Function12,
+                              Key::Null,  // Random assignments, unused
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null,
+                              Key::Null};
+
+constexpr auto escape_keymap = std::array<esc::Key, 56>{Key::KeypadEnter,
+                                                        Key::RCtrl,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::LShiftFake,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::KeypadForwardSlash,
+                                                        Key::RShiftFake,
+                                                        Key::PrintScreenCtrl,
+                                                        Key::RAlt,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::Null,
+                                                        Key::CtrlBreak,
+                                                        Key::HomeGray,
+                                                        Key::UpGray,
+                                                        Key::PageUpGray,
+                                                        Key::Null,
+                                                        Key::LeftGray,
+                                                        Key::Null,
+                                                        Key::RightGray,
+                                                        Key::EndGray,
+                                                        Key::DownGray,
+                                                        Key::PageDownGray,
+                                                        Key::InsertGray,
+                                                        Key::DeleteGray};
+
+// Control Sequence --------------------------------------------------------------------
+
+/**
+ * A control sequence is a sequence of bytes that starts with an escape character and
+ * ends with a byte that is not in the range 0x20-0x2F.
+ * @details The control sequence is made up of parameter bytes, intermediate bytes, and
+ * a final byte. Parameters are parsed into integers up front, in a single pass and
+ * without allocating.
+ * @see https://en.wikipedia.org/wiki/ANSI_escape_code
+ */
+class ControlSequence {
+   public:
+    static constexpr auto max_parameters = std::size_t{16};
+    static constexpr auto max_intermediates = std::size_t{2};
+
+   public:
+    /**
+     * Private parameter marker, one of '<', '=', '>' or '?', or '\0' if none.
+     */
+    char prefix = '\0';
+    std::array<int, max_parameters> parameters{};
+    std::size_t parameter_count = 0;
+    std::array<char, max_intermediates> intermediates{};
+    std::size_t intermediate_count = 0;
+    char final_byte;
+
+   public:
+    /**
+     * Construct a ControlSequence from the bytes after the CSI.
+     * @details Parameters past max_parameters and intermediate bytes past
+     * max_intermediates are ignored. Empty parameters are zero.
+     * @param sequence The bytes after the CSI, including the final byte.
+     * @throws std::runtime_error if the input is empty.
+     */
+    explicit ControlSequence(std::string_view sequence)
+    {
+        if (sequence.empty()) {
+            throw std::runtime_error{"ControlSequence(): Invalid Input"};
+        }
+        final_byte = sequence.back();
+        sequence.remove_suffix(1);
+
+        auto constexpr max_value = 999'999;
+        auto value = 0;
+        auto has_parameter = false;
+        for (auto const c : sequence) {
+            if (c >= '0' && c <= '9') {
+                value = std::min(value * 10 + (c - '0'), max_value);
+                has_parameter = true;
+            }
+            else if (c == ';' || c == ':') {
+                this->push_parameter(value);
+                value = 0;
+                has_parameter = true;
+            }
+            else if (c >= '<' && c <= '?') {
+                prefix = c;
+            }
+            else if (c >= '\x20' && c <= '\x2F' &&
+                     intermediate_count < max_intermediates) {
+                intermediates[intermediate_count++] = c;
+            }
+        }
+        if (has_parameter) {
+            this->push_parameter(value);
+        }
+    }
+
+   public:
+    /**
+     * Return the parameter at \p index, or \p fallback if there are not that many.
+     * @param index    The index of the parameter.
+     * @param fallback The value to return if the parameter is not present.
+     * @return The parameter at \p index.
+     */
+    [[nodiscard]] auto parameter(std::size_t index, int fallback = 0) const -> int
+    {
+        return index < parameter_count ? parameters[index] : fallback;
+    }
+
+   private:
+    void push_parameter(int value)
+    {
+        if (parameter_count < max_parameters) {
+            parameters[parameter_count++] = value;
+        }
+    }
+};
+
+// -------------------------------------------------------------------------------------
+
+/**
+ * Parses a mouse event from a control sequence.
+ * @param cs       The control sequence to parse the mouse event from.
+ * @param previous The last Button pressed, urxvt releases do not name the Button.
+ * @return The parsed mouse event.
+ * @throws std::runtime_error if the mouse event is not parseable.
+ */
+auto parse_mouse(ControlSequence const& cs, esc::Mouse::Button& previous) -> esc::Event
+{
+    auto const is_sgr = cs.prefix == '<';
+    auto const btn = is_sgr ? cs.parameter(0)        // SGR Mode
+                            : cs.parameter(0) - 32;  // URXVT Mode
+    auto const at = esc::Point{cs.parameter(1) - 1, cs.parameter(2) - 1};
+
+    // State
+    using esc::Mouse;
+    auto mouse = Mouse{at, Mouse::Button::None, {}};
+
+    // Modifiers
+    auto constexpr shift = 0b00000100;
+    auto constexpr alt = 0b00001000;
+    auto constexpr ctrl = 0b00010000;
+
+    mouse.modifiers.shift = btn & shift;
+    mouse.modifiers.alt = btn & alt;
+    mouse.modifiers.ctrl = btn & ctrl;
+
+    // Button
+    auto constexpr btn_mask = 0b11000011;
+    mouse.button = static_cast<Mouse::Button>(btn & btn_mask);
+
+    // Move Event
+    auto constexpr move_event = 0b00100000;
+    if (btn & move_event)
+        return esc::MouseMove{mouse};
+
+    // Scroll Event
+    if (mouse.button == Mouse::Button::ScrollUp ||
+        mouse.button == Mouse::Button::ScrollDown) {
+        return esc::MouseWheel{mouse};
+    }
+
+    // Release Event
+    if (cs.final_byte == 'm') {
+        return esc::MouseRelease{mouse};
+    }
+
+    // urxvt btn release does not mention the button that was released.
+    if (!is_sgr && mouse.button == Mouse::Button::None) {
+        mouse.button = previous;
+        return esc::MouseRelease{mouse};
+    }
+
+    // Press Event
+    previous = mouse.button;
+    if (cs.final_byte == 'M') {
+        return esc::MousePress{mouse};
+    }
+
+    throw std::runtime_error{"input_parser.cpp parse_mouse(): Bad Mouse Event Parse"};
+}
+
+/**
+ * Parses a tilde key from a control sequence.
+ * @param cs The control sequence to parse the tilde key from.
+ * @return The parsed tilde key.
+ * @throws std::runtime_error if there are no parameters.
+ */
+auto parse_tilde(ControlSequence const& cs) -> esc::Key
+{
+    if (cs.parameter_count == 0) {
+        throw std::runtime_error{"input_parser.cpp parse_tilde(): No Parameter Bytes"};
+    }
+    return static_cast<esc::Key>(127 + cs.parameter(0));
+}
+
+/**
+ * Parses a key from a control sequence.
+ * @param cs The control sequence to parse the key from.
+ * @return The parsed key.
+ * @throws std::runtime_error if the final byte is unknown or there is a parsing error.
+ */
+auto parse_key(ControlSequence const& cs) -> esc::Key
+{
+    switch (cs.final_byte) {
+        using Key = esc::Key;
+        case 'A': return Key::ArrowUp;
+        case 'B': return Key::ArrowDown;
+        case 'C': return Key::ArrowRight;
+        case 'D': return Key::ArrowLeft;
+        case 'E': return Key::Begin;
+        case 'F': return Key::End;
+        case 'G': return Key::PageDown;
+        case 'H': return Key::Home;
+        case 'I': return Key::PageUp;
+        case 'L': return Key::Insert;
+        case 'P': return Key::Function1;
+        case 'Q': return Key::Function2;
+        case 'R': return Key::Function3;
+        case 'S': return Key::Function4;
+        case 'Z': return Key::BackTab;
+        case '~': return parse_tilde(cs);
+    }
+    throw std::runtime_error{"input_parser.cpp parse_key(): Unknown final_byte: " +
+                             std::string(1, cs.final_byte)};
+}
+
+/**
+ * Parses the key modifiers from a control sequence.
+ * @param cs The control sequence to parse the key modifiers from.
+ * @return The parsed key modifiers.
+ * @throws std::runtime_error if the modifier parameter is unknown.
+ */
+auto parse_key_modifiers(ControlSequence const& cs) -> esc::Mod
+{
+    if (cs.parameter_count < 2) {
+        return static_cast<esc::Mod>(0);
+    }
+    auto const mod = cs.parameter(1);
+    switch (mod) {
+        using esc::Mod;
+        case 2: return Mod::Shift;
+        case 3: return Mod::Alt;
+        case 4: return Mod::Shift | Mod::Alt;
+        case 5: return Mod::Ctrl;
+        case 6: return Mod::Shift | Mod::Ctrl;
+        case 7: return Mod::Ctrl | Mod::Alt;
+        case 8: return Mod::Shift | Mod::Ctrl | Mod::Alt;
+        case 9: return Mod::Meta;
+        case 10: return Mod::Shift | Mod::Meta;
+        case 11: return Mod::Alt | Mod::Meta;
+        case 12: return Mod::Shift | Mod::Alt | Mod::Meta;
+        case 13: return Mod::Ctrl | Mod::Meta;
+        case 14: return Mod::Shift | Mod::Ctrl | Mod::Meta;
+        case 15: return Mod::Ctrl | Mod::Alt | Mod::Meta;
+        case 16: return Mod::Shift | Mod::Ctrl | Mod::Alt | Mod::Meta;
+    }
+    throw std::runtime_error{"input_parser.cpp parse_key_modifiers(): Unknown Mod: " +
+                             std::to_string(mod)};
+}
+
+/**
+ * Parses a control sequence into an Event.
+ * @details This will only produce a mouse or key event.
+ * @param cs       The control sequence to parse.
+ * @param previous The last mouse Button pressed.
+ * @return The parsed Event.
+ */
+auto parse(ControlSequence const& cs, esc::Mouse::Button& previous) -> esc::Event
+{
+    if (cs.final_byte == 'M' || cs.final_byte == 'm') {
+        return parse_mouse(cs, previous);
+    }
+    return esc::KeyPress{parse_key(cs) | parse_key_modifiers(cs)};
+}
+
+/**
+ * Parses a Token from the Lexer into an Event.
+ * @details Text and Escaped Tokens produce a key press event, CSI and SS3 Tokens are
+ * parsed as a ControlSequence. OSC, DCS and APC strings are not input Events, and
+ * neither are control sequences that are not a known key or mouse event, like the
+ * kitty keyboard protocol's CSI u.
+ * @param token    The Token to parse.
+ * @param previous The last mouse Button pressed.
+ * @return The parsed Event, or std::nullopt if the Token is not an Event.
+ */
+auto parse(esc::detail::Token const& token, esc::Mouse::Button& previous)
+    -> std::optional<esc::Event>
+{
+    using esc::detail::TokenKind;
+    switch (token.kind) {
+        case TokenKind::Text: {
+            auto bytes = std::array<char, 4>{};
+            std::copy(token.bytes.begin(), token.bytes.end(), bytes.begin());
+            return esc::KeyPress{esc::char32_to_key(esc::detail::u8_to_u32(bytes))};
+        }
+        case TokenKind::Escaped:
+            return esc::KeyPress{static_cast<esc::Key>(token.bytes.front())};
+        case TokenKind::CSI:
+        case TokenKind::SS3:
+            try {
+                return parse(ControlSequence{token.bytes}, previous);
+            }
+            catch (std::runtime_error const&) {
+                return std::nullopt;
+            }
+        case TokenKind::OSC:
+        case TokenKind::DCS:
+        case TokenKind::APC: return std::nullopt;
+    }
+    return std::nullopt;
+}
+
+// Scancodes ---------------------------------------------------------------------------
+
+/**
+ * Hands out bytes from the front of a span to the scancode parser.
+ * @details Reading past the end returns zero and marks the input as short. The result
+ * of a short parse is thrown out, and the bytes are parsed again once more arrive.
+ */
+class ScancodeInput {
+   public:
+    explicit ScancodeInput(std::span<char const> bytes) : bytes_{bytes} {}
+
+   public:
+    [[nodiscard]] auto read_byte() -> unsigned char
+    {
+        if (count_ == bytes_.size()) {
+            is_short_ = true;
+            return 0;
+        }
+        return static_cast<unsigned char>(bytes_[count_++]);
+    }
+
+    /**
+     * Return the number of bytes read.
+     */
+    [[nodiscard]] auto count() const -> std::size_t { return count_; }
+
+    /**
+     * Return true if a read went past the end of the bytes.
+     */
+    [[nodiscard]] auto is_short() const -> bool { return is_short_; }
+
+   private:
+    std::span<char const> bytes_;
+    std::size_t count_ = 0;
+    bool is_short_ = false;
+};
+
+/**
+ * Check if a byte is a key release or a key press.
+ * @param byte The byte to check.
+ * @return True if \p byte is a key release, false if it is a key press.
+ */
+[[nodiscard]] auto is_release(unsigned char byte) -> bool { return byte & 0x80; }
+
+/**
+ * Read and parse a keyboard scancode into a KeyPress or a KeyRelease event.
+ * @param in The bytes to read the scancode from.
+ * @return The parsed Event, or std::nullopt if the scancode is not a key.
+ */
+[[nodiscard]] auto parse_scancode(ScancodeInput& in) -> std::optional<esc::Event>
+{
+    // TODO Cleanup and insert and delete don't quite work.
+    // use `sudo showkey -c` to find scancodes.
+    // TODO Test on other keyboards.
+    auto const byte = in.read_byte();
+    switch (byte) {
+        using namespace esc;
+        case 0xE0: {
+            auto const byte2 = in.read_byte();
+            // Print Screen Press: e0 2a e0 37
+            if (byte2 == 0x2A) {
+                if (auto const byte3 = in.read_byte(); byte3 == 0xE0) {
+                    if (auto const byte4 = in.read_byte(); byte4 == 0x37) {
+                        return KeyPress{Key::PrintScreen};
+                    }
+                }
+            }
+            // Print Screen Release: e0 2a+0x80 e0 37+0x80
+            else if ((byte2 - 0x80) == 0x2A) {
+                if (auto const byte3 = in.read_byte(); byte3 == 0xE0) {
+                    if (auto const byte4 = in.read_byte() - 0x80; byte4 == 0x37) {
+                        return KeyRelease{Key::PrintScreen};
+                    }
+                }
+            }
+
+            // Print Screen w/Shift: e0 37
+            else if (byte2 == 0x37) {
+                return KeyPress{Key::PrintScreenShift};
+            }
+
+            // Print Screen w/Shift: e0 37+0x80
+            else if ((byte2 & 0x7F) == 0x37) {
+                return KeyRelease{Key::PrintScreenShift};
+            }
+
+            // Pause w/left or right ctrl: e0 46 e0 c6
+            else if (byte2 == 0x46) {
+                if (auto const byte3 = in.read_byte(); byte3 == 0xE0) {
+                    if (auto const byte4 = in.read_byte(); byte4 == 0xC6) {
+                        return KeyPress{Key::PauseCtrl};
+                    }
+                }
+            }
+
+            switch (byte2) {
+                case 0x48: return KeyPress{Key::ArrowUp};
+                case 0x48 + 0x80: return KeyRelease{Key::ArrowUp};
+                case 0x50: return KeyPress{Key::ArrowDown};
+                case 0x50 + 0x80: return KeyRelease{Key::ArrowDown};
+                case 0x4D: return KeyPress{Key::ArrowRight};
+                case 0x4D + 0x80: return KeyRelease{Key::ArrowRight};
+                case 0x4B: return KeyPress{Key::ArrowLeft};
+                case 0x4B + 0x80: return KeyRelease{Key::ArrowLeft};
+                default: return std::nullopt;
+            }
+        }
+        case 0xE1: {
+            auto const byte2 = in.read_byte();
+            auto const key_byte = byte2 & 0x7F;
+
+            // Pause: e1 1d 45 e1 9d c5
+            if (byte2 == 0x1D) {
+                if (auto const byte3 = in.read_byte(); byte3 == 0x45) {
+                    if (auto const byte4 = in.read_byte(); byte4 == 0xE1) {
+                        if (auto const byte5 = in.read_byte(); byte5 == 0x9D) {
+                            if (auto const byte6 = in.read_byte(); byte6 == 0xC5) {
+                                return KeyPress{Key::Pause};
+                            }
+                        }
+                    }
+                }
+            }
+            if (key_byte < 0x1C || key_byte > 0x53) {
+                return std::nullopt;
+            }
+            return is_release(byte2) ? Event{KeyRelease{escape_keymap[key_byte - 0x1C]}}
+                                     : Event{KeyPress{escape_keymap[key_byte - 0x1C]}};
+        }
+
+        case 0x54: return KeyPress{Key::PrintScreenAlt};
+        case 0x54 + 0x80: return KeyRelease{Key::PrintScreenAlt};
+
+        case 0x00:  // Keyboard Error
+        case 0xAA:  // Basic Assurance Test OK
+        case 0xEE:  // Result of echo command
+        case 0xF1:  // Reply to command a4:Password not installed
+        case 0xFA:  // Acknowledge from kbd
+        case 0xFC:  // BAT error or Mouse transmit error
+        case 0xFD:  // Internal failure
+        case 0xFE:  // Keyboard fails to ack, please resend
+        case 0xFF:  // Keyboard erro
+            return std::nullopt;
+
+        default:
+            return is_release(byte) ? Event{KeyRelease{keymap[byte & 0x7F]}}
+                                    : Event{KeyPress{keymap[byte]}};
+    }
+}
+
+// Coalescing --------------------------------------------------------------------------
+
+/**
+ * Return true if \p a and \p b have the same button and keyboard modifiers.
+ */
+[[nodiscard]] auto same_input(esc::Mouse const& a, esc::Mouse const& b) -> bool
+{
+    return a.button == b.button && a.modifiers.shift == b.modifiers.shift &&
+           a.modifiers.ctrl == b.modifiers.ctrl && a.modifiers.alt == b.modifiers.alt;
+}
+
+/**
+ * Merge \p next into \p last if both are MouseMove or both are MouseWheel Events,
+ * with the same button and modifiers.
+ * @param last The last Event queued, updated if \p next is merged.
+ * @param next The Event about to be queued.
+ * @return True if \p next was merged into \p last.
+ */
+[[nodiscard]] auto coalesce(esc::Event& last, esc::Event const& next) -> bool
+{
+    if (auto const* const move = std::get_if<esc::MouseMove>(&next)) {
+        auto* const last_move = std::get_if<esc::MouseMove>(&last);
+        if (last_move == nullptr || !same_input(last_move->mouse, move->mouse)) {
+            return false;
+        }
+        last_move->mouse.at = move->mouse.at;
+        return true;
+    }
+    if (auto const* const wheel = std::get_if<esc::MouseWheel>(&next)) {
+        auto* const last_wheel = std::get_if<esc::MouseWheel>(&last);
+        if (last_wheel == nullptr || !same_input(last_wheel->mouse, wheel->mouse)) {
+            return false;
+        }
+        last_wheel->mouse.at = wheel->mouse.at;
+        last_wheel->count += wheel->count;
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+namespace esc {
+
+auto InputParser::pollable_fds() -> std::array<int, 3>
+{
+    return {STDIN_FILENO, detail::tty_file_descriptor.value_or(-1),
+            detail::resize_fd()};
+}
+
+void InputParser::feed(std::span<char const> bytes, Clock::time_point read_at)
+{
+    // A Token that began in an earlier call keeps the time of that read.
+    if (!lexer_.is_pending()) {
+        token_read_at_ = read_at;
+    }
+    while (auto const token = lexer_.next(bytes)) {
+        this->push(*token);
+        token_read_at_ = read_at;
+    }
+}
+
+void InputParser::feed_scancodes(std::span<char const> bytes, Clock::time_point read_at)
+{
+    scancodes_.append(bytes.data(), bytes.size());
+    auto rest = std::span<char const>{scancodes_};
+    while (!rest.empty()) {
+        auto in = ScancodeInput{rest};
+        auto const event = ::parse_scancode(in);
+        if (in.is_short()) {
+            break;
+        }
+        if (event.has_value()) {
+            events_.push_back({*event, {read_at, Clock::now()}});
+        }
+        rest = rest.subspan(in.count());
+    }
+    scancodes_.erase(0, scancodes_.size() - rest.size());
+}
+
+void InputParser::feed_resize() { detail::drain_resize_fd(); }
+
+void InputParser::flush()
+{
+    if (auto const token = lexer_.idle(); token.has_value()) {
+        this->push(*token);
+    }
+}
+
+auto InputParser::next_event() -> std::optional<Event>
+{
+    if (!events_.empty()) {
+        auto const queued = events_.front();
+        events_.pop_front();
+        last_timing_ = queued.timing;
+        return queued.event;
+    }
+    if (detail::window_resize_sig == 1) {
+        detail::drain_resize_fd();  // Already reported by the flag.
+        detail::window_resize_sig = 0;
+        auto const now = Clock::now();
+        if (!resize_due_.has_value()) {
+            resize_read_at_ = now;
+        }
+        resize_due_ = now + debounce_;
+    }
+    if (resize_due_.has_value() && Clock::now() >= *resize_due_) {
+        resize_due_ = std::nullopt;
+        auto const event = Resize{cached_terminal_area()};
+        last_timing_ = {resize_read_at_, Clock::now()};
+        return event;
+    }
+    return std::nullopt;
+}
+
+auto InputParser::resize_timeout() const -> int
+{
+    if (!resize_due_.has_value()) {
+        return -1;
+    }
+    auto const remaining =
+        std::chrono::ceil<std::chrono::milliseconds>(*resize_due_ - Clock::now());
+    return std::max(0, static_cast<int>(remaining.count()));
+}
+
+void InputParser::push(detail::Token const& token)
+{
+    if (detail::take_probe_reply(token)) {
+        return;
+    }
+    auto const event = ::parse(token, previous_button_);
+    if (!event.has_value()) {
+        return;
+    }
+    // Keys are read as scancodes from the tty in alt keyboard mode.
+    if (detail::tty_file_descriptor.has_value() &&
+        std::holds_alternative<KeyPress>(*event)) {
+        return;
+    }
+    // A merged Event keeps the read time of the oldest input in it.
+    if (coalesce_ && !events_.empty() && ::coalesce(events_.back().event, *event)) {
+        events_.back().timing.parsed = Clock::now();
+        return;
+    }
+    events_.push_back({*event, {token_read_at_, Clock::now()}});
+}
+
+}  // namespace esc
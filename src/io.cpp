@@ -2,1059 +2,405 @@
 
 #include <algorithm>
 #include <array>
-#include <cassert>
 #include <cerrno>
-#include <csignal>
-#include <cstdint>
+#include <chrono>
+#include <cstddef>
 #include <cstdio>
-#include <iterator>
+#include <limits>
 #include <optional>
+#include <span>
 #include <stdexcept>
 #include <string>
-#include <variant>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 #include <poll.h>
-#include <sys/ioctl.h>
-#include <termios.h>
 #include <unistd.h>
 
-#include <esc/area.hpp>
-#include <esc/detail/signals.hpp>
+#include <esc/capabilities.hpp>
+#include <esc/detail/capability_cache.hpp>
+#include <esc/detail/query.hpp>
 #include <esc/detail/transcode.hpp>
-#include <esc/detail/tty_file.hpp>
 #include <esc/event.hpp>
-#include <esc/key.hpp>
-#include <esc/terminal.hpp>
+#include <esc/input_parser.hpp>
 
 namespace {
 
-using esc::Key;
-constexpr auto keymap =
-    std::array<esc::Key, 128>{Key::Null,
-                              Key::Escape,
-                              Key::One,
-                              Key::Two,
-                              Key::Three,
-                              Key::Four,
-                              Key::Five,
-                              Key::Six,
-                              Key::Seven,
-                              Key::Eight,
-                              Key::Nine,
-                              Key::Zero,
-                              Key::Minus,
-                              Key::Equals,
-                              Key::Backspace,
-                              Key::Tab,
-                              Key::q,
-                              Key::w,
-                              Key::e,
-                              Key::r,
-                              Key::t,
-                              Key::y,
-                              Key::u,
-                              Key::i,
-                              Key::o,
-                              Key::p,
-                              Key::LeftBracket,
-                              Key::RightBracket,
-                              Key::Enter,
-                              Key::LCtrl,
-                              Key::a,
-                              Key::s,
-                              Key::d,
-                              Key::f,
-                              Key::g,
-                              Key::h,
-                              Key::j,
-                              Key::k,
-                              Key::l,
-                              Key::Semicolon,
-                              Key::Apostrophe,
-                              Key::Accent,
-                              Key::LShift,
-                              Key::Backslash,
-                              Key::z,
-                              Key::x,
-                              Key::c,
-                              Key::v,
-                              Key::b,
-                              Key::n,
-                              Key::m,
-                              Key::Comma,
-                              Key::Period,
-                              Key::ForwardSlash,
-                              Key::RShift,
-                              Key::KeypadAsterisk,
-                              Key::LAlt,
-                              Key::Space,
-                              Key::CapsLock,
-                              Key::Function1,
-                              Key::Function2,
-                              Key::Function3,
-                              Key::Function4,
-                              Key::Function5,
-                              Key::Function6,
-                              Key::Function7,
-                              Key::Function8,
-                              Key::Function9,
-                              Key::Function10,
-                              Key::NumLock,
-                              Key::ScrollLock,
-                              Key::Keypad7,
-                              Key::Keypad8,
-                              Key::Keypad9,
-                              Key::KeypadMinus,
-                              Key::Keypad4,
-                              Key::Keypad5,
-                              Key::Keypad6,
-                              Key::KeypadPlus,
-                              Key::Keypad1,
-                              Key::Keypad2,
-                              Key::Keypad3,
-                              Key::Keypad0,
-                              Key::KeypadPeriod,
-                              Key::AltSystemRequest,  // "magic SysRq key"
-                              Key::Null,              // Not commonly used.
-                              Key::Null,  // Unlabeled key on non-us keyboards
-                              Key::Function11,
-                              Key::Function12,
-                              Key::Null,  // Random assignments, unused
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null,
-                              Key::Null};
-
-constexpr auto escape_keymap = std::array<esc::Key, 56>{Key::KeypadEnter,
-                                                        Key::RCtrl,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::LShiftFake,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::KeypadForwardSlash,
-                                                        Key::RShiftFake,
-                                                        Key::PrintScreenCtrl,
-                                                        Key::RAlt,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::Null,
-                                                        Key::CtrlBreak,
-                                                        Key::HomeGray,
-                                                        Key::UpGray,
-                                                        Key::PageUpGray,
-                                                        Key::Null,
-                                                        Key::LeftGray,
-                                                        Key::Null,
-                                                        Key::RightGray,
-                                                        Key::EndGray,
-                                                        Key::DownGray,
-                                                        Key::PageDownGray,
-                                                        Key::InsertGray,
-                                                        Key::DeleteGray};
+// Input -------------------------------------------------------------------------------
 
 /**
- * Return true if there is nothing to read from file descriptor \p fd.
- * @details Waits up to \p timeout for bytes to be written to the file.
- * @param fd         The file descriptor to check for readability.
- * @param timeout_ms The maximum time to wait for bytes to be written to the file.
- * @return True if there is nothing to read from the file, false if there is something
- * to read.
+ * Parses everything read for read() and read_events().
  */
-[[nodiscard]] auto is_file_readable(int fd, int timeout_ms) -> bool
-{
-    auto file = pollfd{};
-    file.fd = fd;
-    file.events = POLLIN;
-
-    auto const result = poll(&file, 1, timeout_ms);
-
-    auto constexpr error = -1;
-    auto constexpr timeout = 0;
-
-    if (result == error) {
-        if (errno == EINTR) {  // A signal interrupted poll.
-            return true;
-        }
-        throw std::runtime_error{"io.cpp is_file_readable(): Poll Error"};
-    }
-    if (result == timeout) {
-        return true;
-    }
-    if (result > 0 && static_cast<bool>(file.revents & POLLIN)) {
-        return false;
-    }
-    throw std::logic_error{"io.cpp is_file_readable(): logic_error."};
-}
+auto input_parser = esc::InputParser{};
 
 /**
- * Return true if there is nothing to read from stdin.
- * @details Waits up to \p timeout for bytes to be written to stdin.
- * @param timeout_ms The maximum time to wait for bytes to be written to stdin.
- * @return True if there is nothing to read from stdin, false if there is something to
- * read.
+ * Reports input-to-flush latency, set by set_latency_hook().
  */
-[[nodiscard]] auto is_stdin_empty(int timeout_ms) -> bool
-{
-    return is_file_readable(STDIN_FILENO, timeout_ms);
-}
+auto latency_hook = esc::LatencyHook{};
 
 /**
- * Read a single byte from file descriptor \p fd.
- * @param fd The file descriptor to read from.
- * @return The byte read from \p fd.
- * @throws std::runtime_error if there is an error reading from \p fd.
+ * The timing of the oldest Event read since the last report to latency_hook.
  */
-auto read_byte(int fd) -> unsigned char
-{
-    unsigned char byte = '\0';
-    auto size = ::read(fd, &byte, 1);
-    if (size != 1) {
-        throw std::runtime_error{"read_byte(fd): Failed: " + std::to_string(errno)};
-    }
-    return byte;
-}
+auto unflushed_input = std::optional<esc::EventTiming>{};
 
 /**
- * Read a single byte from file descriptor \p fd, blocking until a byte is read or \p
- * timeout_ms passes.
- * @param fd         The file descriptor to read from.
- * @param timeout_ms The maximum time to wait for a byte to be read.
- * @return The byte read from \p fd, or std::nullopt if the timeout is reached.
+ * Take the next Event from input_parser, keeping its timing for latency_hook.
+ * @return The next Event, or std::nullopt if there are none.
  */
-auto read_byte(int fd, int timeout_ms) -> std::optional<char>
+[[nodiscard]] auto next_event() -> std::optional<esc::Event>
 {
-    if (!is_stdin_empty(timeout_ms)) {
-        return read_byte(fd);
+    auto event = input_parser.next_event();
+    if (event.has_value() && latency_hook && !unflushed_input.has_value()) {
+        unflushed_input = input_parser.last_event_timing();
     }
-    return std::nullopt;
+    return event;
 }
 
-// Mouse -------------------------------------------------------------------------------
-
-/**
- * Used by urxvt to keep track of the previous mouse button pressed for mouse release
- * events.
- */
-auto previous_mouse_btn = esc::Mouse::Button{};
-
-// Token -------------------------------------------------------------------------------
-
 /**
- * A control sequence is a sequence of bytes that starts with an escape character and
- * ends with a byte that is not in the range 0x20-0x2F.
- * @details The control sequence is made up of parameter bytes, intermediate bytes, and
- * a final byte.
- * @see https://en.wikipedia.org/wiki/ANSI_escape_code
+ * Read whatever is ready from \p fd with a single read(2), up to the buffer size.
+ * @details Blocks until at least one byte is available, retries on EINTR.
+ * @param fd     The file descriptor to read from.
+ * @param buffer The memory to read into.
+ * @return The bytes read, at the front of \p buffer.
+ * @throws std::runtime_error if there is an error reading from the file.
  */
-class ControlSequence {
-   public:
-    std::string parameter_bytes;
-    std::string intermediate_bytes;
-    char final_byte;
-
-   public:
-    /**
-     * Construct a ControlSequence from a string of bytes.
-     * @param sequence The string of bytes to construct the ControlSequence from.
-     * @throws std::runtime_error if the input is empty.
-     */
-    explicit ControlSequence(std::string sequence)
-    {
-        if (sequence.empty()) {
-            throw std::runtime_error{"ControlSequence(): Invalid Input"};
+[[nodiscard]] auto read_some(int fd, std::span<char> buffer) -> std::span<char const>
+{
+    while (true) {
+        auto const size = ::read(fd, buffer.data(), buffer.size());
+        if (size > 0) {
+            return buffer.first(static_cast<std::size_t>(size));
+        }
+        if (size == -1 && errno == EINTR) {
+            continue;
         }
-        std::ranges::copy_if(sequence, std::back_inserter(parameter_bytes),
-                             [](char c) { return c >= '\x30' && c <= '\x3F'; });
-        std::ranges::copy_if(sequence, std::back_inserter(intermediate_bytes),
-                             [](char c) { return c >= '\x20' && c <= '\x2F'; });
-        final_byte = sequence.back();
+        throw std::runtime_error{"io.cpp read_some(): Failed: " +
+                                 std::to_string(errno)};
     }
-};
-
-/**
- * Represents an escaped character token.
- */
-struct Escaped {
-    char character;
-};
-
-/**
- * Represents a UTF-8 character token.
- */
-struct UTF8 {
-    std::array<char, 4> bytes;
-};
-
-/**
- * Represents a window resize token.
- */
-struct Window {};
-
-/**
- * A Token is one of ControlSequence, Escaped, UTF8, and Window parsed from the
- * terminal's input stream.
- */
-using Token = std::variant<ControlSequence, Escaped, UTF8, Window>;
-
-// -------------------------------------------------------------------------------------
+}
 
 /**
- * Retrieves the integer type parameter at \p index, returns a type T.
- * @tparam T     The type to return.
- * @tparam Index The index of the parameter to retrieve.
- * @param bytes The parameter bytes to retrieve the parameter from.
- * @return The parameter at \p index.
+ * Return true if there is something to read from file descriptor \p fd right now.
  */
-template <typename T, std::size_t Index>
-auto parameter(std::string bytes) -> T
+[[nodiscard]] auto is_readable_now(int fd) -> bool
 {
-    if constexpr (Index != 0) {  // silence gcc warning
-        for (auto count = 0uL; count < Index; ++count) {
-            bytes = bytes.substr(bytes.find(';', 0) + 1);
-        }
-    }
-
-    return std::stoul(bytes.substr(0, bytes.find(';', 0)));
+    auto file = pollfd{fd, POLLIN, 0};
+    return ::poll(&file, 1, 0) > 0;
 }
 
 /**
- * Parses a mouse event from a control sequence.
- * @param cs The control sequence to parse the mouse event from.
- * @return The parsed mouse event.
- * @throws std::runtime_error if the mouse event is not parseable.
+ * Wait up to \p timeout_ms for input, and feed whatever is read to input_parser.
+ * @details A read that fills the buffer is not flushed unless stdin has nothing more
+ * ready, so an escape sequence split by the buffer size is not cut in two.
+ * @param timeout_ms The maximum time to wait, zero does not wait, -1 waits forever.
+ * @return False if the timeout is reached, true if anything might have been read.
+ * @throws std::runtime_error if there is an error polling or reading.
  */
-auto parse_mouse(ControlSequence cs) -> esc::Event
+auto wait_and_feed(int timeout_ms) -> bool
 {
-    auto const is_sgr = cs.parameter_bytes.front() == '<';
-    auto const btn = [&] {
-        // SGR Mode
-        if (is_sgr) {
-            cs.parameter_bytes = cs.parameter_bytes.substr(1);
-            return parameter<int, 0>(cs.parameter_bytes);
-        }
-        // URXVT Mode
-        return parameter<int, 0>(cs.parameter_bytes) - 32;
-    }();
-    auto const at = esc::Point{parameter<int, 1>(cs.parameter_bytes) - 1,
-                               parameter<int, 2>(cs.parameter_bytes) - 1};
-
-    // State
-    using esc::Mouse;
-    auto mouse = Mouse{at, Mouse::Button::None, {}};
-
-    // Modifiers
-    auto constexpr shift = 0b00000100;
-    auto constexpr alt = 0b00001000;
-    auto constexpr ctrl = 0b00010000;
-
-    mouse.modifiers.shift = btn & shift;
-    mouse.modifiers.alt = btn & alt;
-    mouse.modifiers.ctrl = btn & ctrl;
-
-    // Button
-    auto constexpr btn_mask = 0b11000011;
-    mouse.button = static_cast<Mouse::Button>(btn & btn_mask);
-
-    // Move Event
-    auto constexpr move_event = 0b00100000;
-    if (btn & move_event)
-        return esc::MouseMove{mouse};
-
-    // Scroll Event
-    if (mouse.button == Mouse::Button::ScrollUp ||
-        mouse.button == Mouse::Button::ScrollDown) {
-        return esc::MouseWheel{mouse};
+    auto const fds = esc::InputParser::pollable_fds();
+    auto files = std::array<pollfd, 3>{};
+    for (auto i = std::size_t{0}; i < files.size(); ++i) {
+        files[i] = {fds[i], POLLIN, 0};
     }
 
-    // Release Event
-    if (cs.final_byte == 'm') {
-        return esc::MouseRelease{mouse};
+    auto const result = ::poll(files.data(), files.size(), timeout_ms);
+    if (result == -1) {
+        if (errno == EINTR) {  // A signal interrupted poll.
+            return true;
+        }
+        throw std::runtime_error{"io.cpp wait_and_feed(): Poll Error"};
     }
-
-    // urxvt btn release does not mention the button that was released.
-    if (!is_sgr && mouse.button == Mouse::Button::None) {
-        mouse.button = previous_mouse_btn;
-        return esc::MouseRelease{mouse};
+    if (result == 0) {
+        return false;
     }
 
-    // Press Event
-    previous_mouse_btn = mouse.button;
-    if (cs.final_byte == 'M') {
-        return esc::MousePress{mouse};
+    auto buffer = std::array<char, 4096>{};
+    if (files[0].revents != 0) {
+        auto const bytes = ::read_some(files[0].fd, buffer);
+        input_parser.feed(bytes, std::chrono::steady_clock::now());
+        if (bytes.size() < buffer.size() || !::is_readable_now(files[0].fd)) {
+            input_parser.flush();
+        }
     }
-
-    throw std::runtime_error{"io.cpp::parse_mouse(): Bad Mouse Event Parse"};
-}
-
-/**
- * Returns the number of parameters in a control sequence string.
- * @details Parameters are delimited by semicolons.
- * @param parameter_bytes The parameter bytes to count.
- * @return The number of parameters in \p parameter_bytes.
- */
-auto parameter_count(std::string parameter_bytes) -> std::size_t
-{
-    return parameter_bytes.empty() ? 0 : std::ranges::count(parameter_bytes, ';') + 1;
-}
-
-/**
- * Parses a tilde key from a control sequence.
- * @param parameter_bytes The parameter bytes to parse the tilde key from.
- * @return The parsed tilde key.
- * @throws std::runtime_error if there are no parameter bytes.
- */
-auto parse_tilde(std::string parameter_bytes) -> esc::Key
-{
-    if (parameter_count(parameter_bytes) == 0) {
-        throw std::runtime_error{"io.cpp: parse_tilde: No Parameter Bytes"};
+    if (files[1].revents != 0) {
+        auto const bytes = ::read_some(files[1].fd, buffer);
+        input_parser.feed_scancodes(bytes, std::chrono::steady_clock::now());
     }
-    return static_cast<esc::Key>(127 + parameter<int, 0>(parameter_bytes));
-}
-
-/**
- * Parses a key from a control sequence.
- * @param cs The control sequence to parse the key from.
- * @return The parsed key.
- * @throws std::runtime_error if the final byte is unknown or there is a parsing error.
- */
-auto parse_key(ControlSequence cs) -> esc::Key
-{
-    switch (cs.final_byte) {
-        using Key = esc::Key;
-        case 'A': return Key::ArrowUp;
-        case 'B': return Key::ArrowDown;
-        case 'C': return Key::ArrowRight;
-        case 'D': return Key::ArrowLeft;
-        case 'E': return Key::Begin;
-        case 'F': return Key::End;
-        case 'G': return Key::PageDown;
-        case 'H': return Key::Home;
-        case 'I': return Key::PageUp;
-        case 'L': return Key::Insert;
-        case 'P': return Key::Function1;
-        case 'Q': return Key::Function2;
-        case 'R': return Key::Function3;
-        case 'S': return Key::Function4;
-        case 'Z': return Key::BackTab;
-        case '~': return parse_tilde(cs.parameter_bytes);
+    if (files[2].revents != 0) {
+        input_parser.feed_resize();
     }
-    throw std::runtime_error{"io.cpp parse_key(): Unknown final_byte: " +
-                             std::string(1, cs.final_byte)};
+    return true;
 }
 
 /**
- * Parses the key modifiers from a control sequence.
- * @param parameter_bytes The parameter bytes to parse the key modifiers from.
- * @return The parsed key modifiers.
- * @throws std::runtime_error if the parameter bytes are empty.
+ * Read up to \p limit Events, waiting only for the first one.
+ * @param timeout_ms The maximum time to wait for the first Event.
+ * @param limit      The maximum number of Events to read.
+ * @param push       Called with each Event read.
+ * @return The number of Events read.
  */
-auto parse_key_modifiers(std::string parameter_bytes) -> esc::Mod
+template <typename Push>
+auto read_burst(int timeout_ms, std::size_t limit, Push&& push) -> std::size_t
 {
-    if (parameter_count(parameter_bytes) < 2) {
-        return static_cast<esc::Mod>(0);
+    if (limit == 0) {
+        return 0;
     }
-    auto const mod = parameter<int, 1>(parameter_bytes);
-    switch (mod) {
-        using esc::Mod;
-        case 2: return Mod::Shift;
-        case 3: return Mod::Alt;
-        case 4: return Mod::Shift | Mod::Alt;
-        case 5: return Mod::Ctrl;
-        case 6: return Mod::Shift | Mod::Ctrl;
-        case 7: return Mod::Ctrl | Mod::Alt;
-        case 8: return Mod::Shift | Mod::Ctrl | Mod::Alt;
-        case 9: return Mod::Meta;
-        case 10: return Mod::Shift | Mod::Meta;
-        case 11: return Mod::Alt | Mod::Meta;
-        case 12: return Mod::Shift | Mod::Alt | Mod::Meta;
-        case 13: return Mod::Ctrl | Mod::Meta;
-        case 14: return Mod::Shift | Mod::Ctrl | Mod::Meta;
-        case 15: return Mod::Ctrl | Mod::Alt | Mod::Meta;
-        case 16: return Mod::Shift | Mod::Ctrl | Mod::Alt | Mod::Meta;
+    auto const first = esc::read(timeout_ms);
+    if (!first.has_value()) {
+        return 0;
     }
-    throw std::runtime_error{"io.cpp parse_key_modifiers(): Unknown Mod: " +
-                             std::to_string(mod)};
-}
-
-/**
- * Parses a control sequence into an Event.
- * @details This will only produce a mouse or key event.
- * @param cs The control sequence to parse.
- * @return The parsed Event.
- */
-auto parse(ControlSequence const& cs) -> esc::Event
-{
-    if (cs.final_byte == 'M' || cs.final_byte == 'm') {
-        return parse_mouse(cs);
+    push(*first);
+    auto count = std::size_t{1};
+    while (count < limit) {
+        auto const event = ::next_event();
+        if (!event.has_value()) {
+            break;
+        }
+        push(*event);
+        ++count;
     }
-    return esc::KeyPress{parse_key(cs) | parse_key_modifiers(cs.parameter_bytes)};
+    return count;
 }
 
-/**
- * Parses an escaped character into an Event.
- * @details This will only produce a key press event.
- * @param e The escaped character to parse.
- * @return The parsed Event.
- */
-auto parse(Escaped e) -> esc::Event
-{
-    return esc::KeyPress{static_cast<esc::Key>(e.character)};
-}
+// Output ------------------------------------------------------------------------------
 
 /**
- * Parses a UTF8 character into an Event.
- * @details This will only produce a key press event.
- * @param x The UTF8 character to parse.
- * @return The parsed Event.
+ * Write all of \p bytes to file descriptor \p fd.
+ * @details Loops on partial writes, retries on EINTR and waits for \p fd to be
+ * writable on EAGAIN.
+ * @param fd    The file descriptor to write to.
+ * @param bytes The bytes to write.
+ * @throws std::runtime_error if there is an error writing to \p fd.
  */
-auto parse(UTF8 x) -> esc::Event
+void write_all(int fd, std::string_view bytes)
 {
-    return esc::KeyPress{esc::char32_to_key(esc::detail::u8_to_u32(x.bytes))};
+    while (!bytes.empty()) {
+        auto const result = ::write(fd, bytes.data(), bytes.size());
+        if (result >= 0) {
+            bytes.remove_prefix(static_cast<std::size_t>(result));
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            auto file = pollfd{fd, POLLOUT, 0};
+            if (::poll(&file, 1, -1) == -1 && errno != EINTR) {
+                throw std::runtime_error{"io.cpp write_all(): Poll Error"};
+            }
+            continue;
+        }
+        throw std::runtime_error{"io.cpp write_all(): Failed: " +
+                                 std::to_string(errno)};
+    }
 }
 
 /**
- * Parses a window resize token into an Event.
- * @param w The window resize token.
- * @return The parsed Event.
- */
-auto parse(Window) -> esc::Event { return esc::Resize{esc::terminal_area()}; }
-
-// Lexer -------------------------------------------------------------------------------
-
-struct Initial {};
-
-struct Final {
-    Token result;
-};
-
-struct Escape {};
-
-struct MaybeEscaped {};
-
-struct MaybeCSI {
-    char c;  // The possibly escaped char.
-};
-
-struct CSI {
-    std::string value;
-};
-
-/**
- * Used to parse a control sequence from the terminal.
- * @details Creates a state machine to do the parsing with this variant and the
- * next_state function overloads.
+ * Holds bytes from write(...) until they are sent to stdout by flush().
+ * @details Whatever is left in the buffer is written at program exit.
  */
-using Lexer = std::variant<Initial, Final, Escape, MaybeEscaped, MaybeCSI, CSI, UTF8>;
-
-// -------------------------------------------------------------------------------------
+class WriteBuffer {
+   public:
+    static constexpr auto default_size = std::size_t{1} << 16;
 
-auto constexpr escape = '\033';
+   public:
+    WriteBuffer() { bytes_.reserve(default_size); }
 
-using esc::detail::window_resize_sig;
+    WriteBuffer(WriteBuffer const&) = delete;
+    auto operator=(WriteBuffer const&) -> WriteBuffer& = delete;
 
-auto next_state(Initial) -> Lexer
-{
-    auto constexpr timeout = 30;  // milliseconds
-    while (true) {
-        if (window_resize_sig == 1) {
-            window_resize_sig = 0;
-            return Final{Window{}};
+    ~WriteBuffer()
+    {
+        try {
+            this->flush();
         }
-        if (auto const b = read_byte(STDIN_FILENO, timeout); b.has_value()) {
-            if (*b == escape) {
-                return Escape{};
-            }
-            else {
-                return UTF8{{*b}};
-            }
+        catch (...) {
         }
     }
-}
 
-auto next_state(Final f) -> Lexer { return f; }
-
-auto next_state(Escape) -> Lexer
-{
-    if (is_stdin_empty(0)) {
-        return Final{UTF8{{escape}}};
-    }
-    else {
-        return MaybeEscaped{};
+   public:
+    void append(char c)
+    {
+        bytes_.push_back(c);
+        this->flush_if_full();
     }
-}
 
-auto next_state(MaybeEscaped) -> Lexer
-{
-    auto const c = read_byte(STDIN_FILENO);
-    if (c != '[' && c != 'O') {
-        return Final{Escaped{(char)c}};
-    }
-    else {
-        return MaybeCSI{(char)c};
+    void append(std::string_view sv)
+    {
+        bytes_.append(sv);
+        this->flush_if_full();
     }
-}
 
-auto next_state(MaybeCSI state) -> Lexer
-{
-    if (is_stdin_empty(0)) {
-        return Final{Escaped{state.c}};
-    }
-    else {
-        return CSI{""};
+    void append(std::u32string_view sv)
+    {
+        esc::detail::u32_to_u8_append(sv, bytes_);
+        this->flush_if_full();
     }
-}
 
-auto next_state(CSI const& state) -> Lexer
-{
-    auto const b = read_byte(STDIN_FILENO);
-    if (b >= 0x40 && b <= 0x7E) {
-        return Final{ControlSequence{state.value + (char)b}};
+    void flush()
+    {
+        // Keep ordering with bytes written through stdio.
+        std::fflush(stdout);
+        if (bytes_.empty()) {
+            return;
+        }
+        write_all(STDOUT_FILENO, bytes_);
+        bytes_.clear();
+        if (latency_hook && unflushed_input.has_value()) {
+            auto const input = *std::exchange(unflushed_input, std::nullopt);
+            latency_hook(input, std::chrono::steady_clock::now());
+        }
     }
-    else {
-        return CSI{state.value + std::string(1, b)};
+
+    void resize(std::size_t size)
+    {
+        size_ = size;
+        bytes_.reserve(size);
     }
-}
 
-/**
- * Returns 1 if all set bits in \p mask match up with set bits in value, zeros in mask
- * are treated as wildcards and can be anything in \p value.
- * @param mask  The mask to compare with.
- * @param value The value to compare with.
- * @return 1 if all set bits in \p mask match up with set bits in \p value, 0 otherwise.
- */
-auto matches_mask(std::uint8_t mask, char value) -> std::uint8_t
-{
-    return static_cast<std::uint8_t>((mask & value) == mask);
-}
+   private:
+    std::string bytes_;
+    std::size_t size_ = default_size;
 
-/**
- * Returns the number of bytes left to read to form a complete utf8 character.
- * @param first The first byte of the utf8 character.
- * @return The number of bytes left to read to form a complete utf8 character.
- * @details This function is branchless.
- * @see https://en.wikipedia.org/wiki/UTF-8
- */
-auto bytes_left_to_read(char first) -> std::uint8_t
-{
-    // utf8 initial bytes
-    auto constexpr mask_1 = std::uint8_t{0b11000000};
-    auto constexpr mask_2 = std::uint8_t{0b11100000};
-    auto constexpr mask_3 = std::uint8_t{0b11110000};
+   private:
+    void flush_if_full()
+    {
+        if (size_ != 0 && bytes_.size() >= size_) {
+            this->flush();
+        }
+    }
+};
 
-    auto count = matches_mask(mask_1, first);
-    count += matches_mask(mask_2, first);
-    count += matches_mask(mask_3, first);
-    return count;
-}
+auto write_buffer = WriteBuffer{};
 
-auto next_state(UTF8 state) -> Lexer
-{
-    auto index = 1;
-    for (auto count = bytes_left_to_read(state.bytes[0]); count != 0; --count) {
-        state.bytes[index++] = read_byte(STDIN_FILENO);
-    }
-    return Final{state};
-}
+}  // namespace
 
-// -------------------------------------------------------------------------------------
+namespace esc::detail {
 
-/**
- * Read a single input command from the terminal.
- * @details This function will block until a command is read from the terminal.
- * @return The command read from the terminal as a Token.
- */
-auto read_single_token() -> Token
+void feed_input(std::span<char const> bytes)
 {
-    auto state = Lexer{Initial{}};
-    while (!std::holds_alternative<Final>(state)) {
-        state = std::visit([](auto s) { return next_state(s); }, state);
+    input_parser.feed(bytes, std::chrono::steady_clock::now());
+    if (!::is_readable_now(STDIN_FILENO)) {
+        input_parser.flush();
     }
-    return std::get<Final>(state).result;
 }
 
-// -------------------------------------------------------------------------------------
-
-/**
- * Read a single Event from stdin.
- * @details This reads a Token from the terminal and then parses it into an Event.
- * @return The Event read from stdin.
- */
-[[nodiscard]] auto do_blocking_read() -> esc::Event
+void drain_probe_replies(std::chrono::milliseconds budget)
 {
-    auto const token = read_single_token();
-    return std::visit([](auto t) { return parse(t); }, token);
+    using Clock = std::chrono::steady_clock;
+    using std::chrono::milliseconds;
+    auto const deadline = Clock::now() + budget;
+    try {
+        while (is_expecting_probe_replies()) {
+            auto const remaining = deadline - Clock::now();
+            auto const ms = std::chrono::duration_cast<milliseconds>(remaining).count();
+            if (ms <= 0 || !::wait_and_feed(static_cast<int>(ms))) {
+                return;
+            }
+        }
+    }
+    catch (std::runtime_error const&) {
+        // stdin closed, there is nothing left to drain.
+    }
 }
 
-/**
- * Check if a byte is a key release or a key press.
- * @param byte The byte to check.
- * @return True if \p byte is a key release, false if it is a key press.
- */
-[[nodiscard]] auto is_release(unsigned char byte) -> bool { return byte & 0x80; }
+}  // namespace esc::detail
 
-/**
- * Read and parse a keyboard scancode into a KeyPress or a KeyRelease event.
- * @param fd The file descriptor to read the scancode from.
- * @return The parsed Event.
- * @throws std::runtime_error if the read fails.
- */
-[[nodiscard]] auto read_and_parse_scancode(int fd) -> std::optional<esc::Event>
-{
-    // TODO Cleanup and insert and delete don't quite work.
-    // use `sudo showkey -c` to find scancodes.
-    // TODO Test on other keyboards.
-    auto const byte = read_byte(fd);
-    switch (byte) {
-        using namespace esc;
-        case 0xE0: {
-            auto const byte2 = read_byte(fd);
-            // Print Screen Press: e0 2a e0 37
-            if (byte2 == 0x2A) {
-                if (auto const byte3 = read_byte(fd); byte3 == 0xE0) {
-                    if (auto const byte4 = read_byte(fd); byte4 == 0x37) {
-                        return KeyPress{Key::PrintScreen};
-                    }
-                }
-            }
-            // Print Screen Release: e0 2a+0x80 e0 37+0x80
-            else if ((byte2 - 0x80) == 0x2A) {
-                if (auto const byte3 = read_byte(fd); byte3 == 0xE0) {
-                    if (auto const byte4 = read_byte(fd) - 0x80; byte4 == 0x37) {
-                        return KeyRelease{Key::PrintScreen};
-                    }
-                }
-            }
+namespace esc {
 
-            // Print Screen w/Shift: e0 37
-            else if (byte2 == 0x37) {
-                return KeyPress{Key::PrintScreenShift};
-            }
+void write(char c) { write_buffer.append(c); }
 
-            // Print Screen w/Shift: e0 37+0x80
-            else if ((byte2 & 0x7F) == 0x37) {
-                return KeyRelease{Key::PrintScreenShift};
-            }
+void write(char32_t c) { write_buffer.append(std::u32string_view{&c, 1}); }
 
-            // Pause w/left or right ctrl: e0 46 e0 c6
-            else if (byte2 == 0x46) {
-                if (auto const byte3 = read_byte(fd); byte3 == 0xE0) {
-                    if (auto const byte4 = read_byte(fd); byte4 == 0xC6) {
-                        return KeyPress{Key::PauseCtrl};
-                    }
-                }
-            }
+void write(std::string_view sv) { write_buffer.append(sv); }
 
-            switch (byte2) {
-                case 0x48: return KeyPress{Key::ArrowUp};
-                case 0x48 + 0x80: return KeyRelease{Key::ArrowUp};
-                case 0x50: return KeyPress{Key::ArrowDown};
-                case 0x50 + 0x80: return KeyRelease{Key::ArrowDown};
-                case 0x4D: return KeyPress{Key::ArrowRight};
-                case 0x4D + 0x80: return KeyRelease{Key::ArrowRight};
-                case 0x4B: return KeyPress{Key::ArrowLeft};
-                case 0x4B + 0x80: return KeyRelease{Key::ArrowLeft};
-                default: return std::nullopt;
-            }
-        }
-        case 0xE1: {
-            auto const byte2 = read_byte(fd);
-            auto const key_byte = byte2 & 0x7F;
+void write(std::string const& s) { write_buffer.append(std::string_view{s}); }
 
-            // Pause: e1 1d 45 e1 9d c5
-            if (byte2 == 0x1D) {
-                if (auto const byte3 = read_byte(fd); byte3 == 0x45) {
-                    if (auto const byte4 = read_byte(fd); byte4 == 0xE1) {
-                        if (auto const byte5 = read_byte(fd); byte5 == 0x9D) {
-                            if (auto const byte6 = read_byte(fd); byte6 == 0xC5) {
-                                return KeyPress{Key::Pause};
-                            }
-                        }
-                    }
-                }
-            }
-            if (key_byte > 0x53) {
-                return std::nullopt;
-            }
-            return is_release(byte2) ? Event{KeyRelease{escape_keymap[key_byte - 0x1C]}}
-                                     : Event{KeyPress{escape_keymap[key_byte - 0x1C]}};
-        }
+void write(char const* s) { write_buffer.append(std::string_view{s}); }
 
-        case 0x54: return KeyPress{Key::PrintScreenAlt};
-        case 0x54 + 0x80: return KeyRelease{Key::PrintScreenAlt};
+void write(std::u32string_view sv) { write_buffer.append(sv); }
 
-        case 0x00:  // Keyboard Error
-        case 0xAA:  // Basic Assurance Test OK
-        case 0xEE:  // Result of echo command
-        case 0xF1:  // Reply to command a4:Password not installed
-        case 0xFA:  // Acknowledge from kbd
-        case 0xFC:  // BAT error or Mouse transmit error
-        case 0xFD:  // Internal failure
-        case 0xFE:  // Keyboard fails to ack, please resend
-        case 0xFF:  // Keyboard erro
-            return std::nullopt;
+void flush() { write_buffer.flush(); }
 
-        default:
-            return is_release(byte) ? Event{KeyRelease{keymap[byte & 0x7F]}}
-                                    : Event{KeyPress{keymap[byte]}};
-    }
-}
+void set_write_buffer_size(std::size_t bytes) { write_buffer.resize(bytes); }
 
-/**
- * Blocks until a read is available for either file descriptor.
- * @param fd_a The first file descriptor to check for readability.
- * @return The file descriptor that is ready, or -1 if timeout or error.
- * @throws std::runtime_error if there is an error polling the file descriptors.
- */
-[[nodiscard]] auto timeout_wait_for_reads(int fd_a, int fd_b, int timeout_ms) -> int
+void set_latency_hook(LatencyHook hook)
 {
-    auto constexpr error = -1;
-    auto constexpr timeout = 0;
-
-    auto files = std::array<pollfd, 2>{{{fd_a, POLLIN, 0}, {fd_b, POLLIN, 0}}};
-    auto const result = poll(files.data(), files.size(), timeout_ms);
-
-    if (result == error) {
-        if (errno == EINTR) {  // A signal interrupted poll.
-            return -1;
-        }
-        throw std::runtime_error{"timeout_wait_for_reads(): Poll Error"};
-    }
-    if (result == timeout) {
-        return -1;
-    }
-    if (result > 0 && static_cast<bool>(files[0].revents & POLLIN)) {
-        return fd_a;
-    }
-    if (result > 0 && static_cast<bool>(files[1].revents & POLLIN)) {
-        return fd_b;
-    }
-    throw std::logic_error{"timeout_wait_for_reads(): logic_error."};
+    latency_hook = std::move(hook);
+    unflushed_input = std::nullopt;
 }
 
-/**
- * Blocks until a read is available for either file descriptor.
- * @param fd_a The first file descriptor to check for readability.
- * @param fd_b The second file descriptor to check for readability.
- * @return The file descriptor that is ready.
- */
-[[nodiscard]] auto blocking_wait_for_reads(int fd_a, int fd_b) -> int
+void begin_frame()
 {
-    // -1 inf timeout
-    return timeout_wait_for_reads(fd_a, fd_b, -1);
+    if (capabilities().synchronized_output) {
+        write("\033[?2026h");
+    }
 }
 
-/**
- * Read an event in alt mode, returns std::nullopt on non-event reads.
- * @details Non-event reads are KeyPress events on stdin, and std::nullopt from tty.
- * @return The event read from stdin or tty, or std::nullopt if the read was not an
- * event.
- * @throws std::logic_error if the file descriptor is not stdin or tty.
- */
-[[nodiscard]] auto do_maybe_alt_blocking_read() -> std::optional<esc::Event>
+void end_frame()
 {
-    auto const file =
-        blocking_wait_for_reads(STDIN_FILENO, *esc::detail::tty_file_descriptor);
-    if (file == STDIN_FILENO) {
-        auto const event = do_blocking_read();
-        if (std::holds_alternative<esc::KeyPress>(event)) {
-            return std::nullopt;
-        }
-        else {
-            return event;
-        }
-    }
-    else if (file == *esc::detail::tty_file_descriptor) {
-        return read_and_parse_scancode(*esc::detail::tty_file_descriptor);
-    }
-    else {
-        throw std::logic_error{"do_maybe_alt_blocking_read(): signal int."};
+    if (capabilities().synchronized_output) {
+        write("\033[?2026l");
     }
 }
 
-/**
- * Read an event in alt mode, throws out stdin key press events. Reads from tty.
- * @details Waits until an actual event is ready, throwing out non-event reads.
- * @return The event read from stdin or tty.
- */
-[[nodiscard]] auto do_alt_blocking_read() -> esc::Event
+auto read() -> Event
 {
     while (true) {
-        auto const file =
-            blocking_wait_for_reads(STDIN_FILENO, *esc::detail::tty_file_descriptor);
-        if (window_resize_sig == 1 || file == STDIN_FILENO) {
-            auto const event = do_blocking_read();
-            if (std::holds_alternative<esc::KeyPress>(event)) {
-                continue;
-            }
-            else {
-                return event;
-            }
-        }
-        else if (file == *esc::detail::tty_file_descriptor) {
-            auto const event =
-                read_and_parse_scancode(*esc::detail::tty_file_descriptor);
-            if (event.has_value()) {
-                return *event;
-            }
-            else {
-                continue;
-            }
+        if (auto const event = ::next_event(); event.has_value()) {
+            return *event;
         }
+        (void)::wait_and_feed(input_parser.resize_timeout());
     }
 }
 
-/**
- * Read a single event from stdin with a timeout, returning std::nullopt if no event is
- * read.
- * @param timeout_ms The maximum time to wait for an event to be read.
- * @return The event read from stdin, or std::nullopt if no event is read.
- */
-[[nodiscard]] auto do_timeout_read(int timeout_ms) -> std::optional<esc::Event>
+auto read(int timeout_ms) -> std::optional<Event>
 {
-    if (window_resize_sig == 1 || !is_stdin_empty(timeout_ms)) {
-        return esc::read();
+    if (timeout_ms < 0) {
+        return read();
     }
-    return std::nullopt;
-}
-
-/**
- * Reads a single token from either STDIN_FILENO or detail::tty_file_descriptor.
- * @details Assumes the tty_file_descriptor is valid. Returns std::nullopt if nothing
- * was read in the given timeout time. Can return earlier than timeout with
- * std::nullopt.
- * @param timeout_ms The maximum time to wait for a token to be read.
- * @return The token read from STDIN_FILENO or detail::tty_file_descriptor, or
- * std::nullopt if no token is read.
- */
-[[nodiscard]] auto do_alt_timeout_read(int timeout_ms) -> std::optional<esc::Event>
-{
-    auto const file = timeout_wait_for_reads(
-        STDIN_FILENO, *esc::detail::tty_file_descriptor, timeout_ms);
-    if (file == STDIN_FILENO) {
-        auto const result = do_blocking_read();
-        if (std::holds_alternative<esc::KeyPress>(result)) {
-            return std::nullopt;
+    using Clock = std::chrono::steady_clock;
+    auto const deadline = Clock::now() + std::chrono::milliseconds{timeout_ms};
+    while (true) {
+        if (auto const event = ::next_event(); event.has_value()) {
+            return event;
         }
-        else {
-            return result;
+        auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - Clock::now());
+        auto const timeout = std::max(0, static_cast<int>(remaining.count()));
+        auto const resize_timeout = input_parser.resize_timeout();
+        if (resize_timeout != -1 && resize_timeout < timeout) {
+            (void)::wait_and_feed(resize_timeout);
+        }
+        else if (!::wait_and_feed(timeout)) {
+            return ::next_event();
         }
-    }
-    else if (file == *esc::detail::tty_file_descriptor) {
-        return do_maybe_alt_blocking_read();
-    }
-    return std::nullopt;
-}
-
-}  // namespace
-
-namespace esc {
-
-void write(char c) { std::putchar(c); }
-
-void write(char32_t c) noexcept(false) { write(esc::detail::u32_to_u8(c)); }
-
-void write(std::string_view sv)
-{
-    for (auto c : sv) {
-        write(c);
     }
 }
 
-void write(std::string const& s) { write(s.c_str()); }
+auto last_event_timing() -> EventTiming { return input_parser.last_event_timing(); }
 
-void write(char const* s) { std::fputs(s, stdout); }
+void set_event_coalescing(bool enabled) { input_parser.set_coalescing(enabled); }
 
-void write(std::u32string_view sv)
+void set_resize_debounce(std::chrono::milliseconds delay)
 {
-    for (auto c : sv) {
-        write(c);
-    }
+    input_parser.set_resize_debounce(delay);
 }
 
-void flush() { std::fflush(::stdout); }
-
-auto read() -> Event
+auto read_events(std::span<Event> out, int timeout_ms) -> std::size_t
 {
-    if (detail::tty_file_descriptor.has_value()) {
-        return do_alt_blocking_read();
-    }
-    else {
-        return do_blocking_read();
-    }
+    auto next = out.begin();
+    return ::read_burst(timeout_ms, out.size(),
+                        [&next](Event const& event) { *next++ = event; });
 }
 
-auto read(int timeout_ms) -> std::optional<Event>
+auto read_events(std::vector<Event>& out, int timeout_ms) -> std::size_t
 {
-    if (detail::tty_file_descriptor.has_value()) {
-        return do_alt_timeout_read(timeout_ms);
-    }
-    else {
-        return do_timeout_read(timeout_ms);
-    }
+    out.clear();
+    return ::read_burst(timeout_ms, std::numeric_limits<std::size_t>::max(),
+                        [&out](Event const& event) { out.push_back(event); });
 }
 
 }  // namespace esc
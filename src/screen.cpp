@@ -0,0 +1,156 @@
+#include <esc/screen.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <esc/area.hpp>
+#include <esc/detail/transcode.hpp>
+#include <esc/glyph.hpp>
+#include <esc/io.hpp>
+#include <esc/point.hpp>
+#include <esc/sequence.hpp>
+
+namespace {
+
+/**
+ * Return the number of cells in a Screen of \p size.
+ * @param size The Area of the Screen.
+ * @return The number of cells, zero if either dimension is negative.
+ */
+[[nodiscard]] auto cell_count(esc::Area size) -> std::size_t
+{
+    if (size.width <= 0 || size.height <= 0) {
+        return 0;
+    }
+    return static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height);
+}
+
+}  // namespace
+
+namespace esc {
+
+Screen::Screen(Area size)
+    : size_{size}, current_(cell_count(size)), next_(cell_count(size))
+{}
+
+auto Screen::size() const -> Area { return size_; }
+
+void Screen::resize(Area size)
+{
+    size_ = size;
+    current_.assign(cell_count(size), Glyph{});
+    next_.assign(cell_count(size), Glyph{});
+    this->invalidate();
+}
+
+auto Screen::operator[](Point p) -> Glyph&
+{
+    return next_[static_cast<std::size_t>(p.y * size_.width + p.x)];
+}
+
+auto Screen::operator[](Point p) const -> Glyph const&
+{
+    return next_[static_cast<std::size_t>(p.y * size_.width + p.x)];
+}
+
+void Screen::fill(Glyph const& g) { next_.assign(next_.size(), g); }
+
+void Screen::invalidate()
+{
+    is_valid_ = false;
+    brush_.invalidate();
+    cursor_.invalidate();
+}
+
+auto Screen::render() -> std::string_view
+{
+    bytes_.clear();
+
+    // When the terminal contents are unknown, start from a blank screen with the
+    // default Brush and compare against blank Glyphs. BlankScreen fills with the
+    // current background color, so the Brush has to be reset first.
+    if (!is_valid_) {
+        current_.assign(next_.size(), Glyph{});
+        brush_.escape_to(bytes_, Brush{});
+        escape_to(bytes_, BlankScreen{});
+    }
+
+    for (auto y = 0; y < size_.height; ++y) {
+        for (auto x = 0; x < size_.width; ++x) {
+            auto const i = static_cast<std::size_t>(y * size_.width + x);
+            auto const& glyph = next_[i];
+            if (glyph == current_[i]) {
+                continue;
+            }
+            this->move_cursor({.x = x, .y = y});
+            if (brush_.brush() != glyph.brush) {
+                this->flush_symbols();
+                brush_.escape_to(bytes_, glyph.brush);
+            }
+            symbols_.push_back(glyph.symbol);
+
+            // Auto-wrap is off, the cursor does not advance past the last column.
+            if (x + 1 < size_.width) {
+                cursor_.advance(1);
+            }
+            else {
+                cursor_.invalidate();
+            }
+        }
+    }
+
+    this->flush_symbols();
+    current_ = next_;
+    is_valid_ = true;
+    return bytes_;
+}
+
+void Screen::move_cursor(Point p)
+{
+    // Rewriting unchanged cells between the cursor and p can be cheaper than a cursor
+    // move, if they are on the same row and share the current Brush.
+    auto const from = cursor_.cursor();
+    if (from.has_value() && from->x == p.x && from->y == p.y) {
+        return;
+    }
+    if (from.has_value() && from->y == p.y && from->x < p.x) {
+        auto const move_cost = cursor_.cost(p);
+        auto const begin = static_cast<std::size_t>(p.y * size_.width + from->x);
+        auto const end = static_cast<std::size_t>(p.y * size_.width + p.x);
+        auto rewrite_cost = std::size_t{0};
+        for (auto i = begin; i != end && rewrite_cost < move_cost; ++i) {
+            rewrite_cost = current_[i].brush == brush_.brush()
+                               ? rewrite_cost + detail::u8_length(current_[i].symbol)
+                               : move_cost;
+        }
+        if (rewrite_cost < move_cost) {
+            for (auto i = begin; i != end; ++i) {
+                symbols_.push_back(current_[i].symbol);
+            }
+            cursor_.advance(p.x - from->x);
+            return;
+        }
+    }
+    this->flush_symbols();
+    cursor_.escape_to(bytes_, p);
+}
+
+void Screen::flush_symbols()
+{
+    detail::u32_to_u8_append(symbols_, bytes_);
+    symbols_.clear();
+}
+
+void Screen::present()
+{
+    auto const bytes = this->render();
+    if (!bytes.empty()) {
+        begin_frame();
+        write(bytes);
+        end_frame();
+    }
+}
+
+}  // namespace esc
@@ -1,7 +1,11 @@
 #include <esc/sequence.hpp>
 
+#include <array>
+#include <cstddef>
+#include <optional>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <variant>
 
@@ -13,175 +17,575 @@
 
 namespace {
 
+using esc::detail::append_int;
+using esc::detail::append_rgb;
+using esc::detail::append_traits;
+using esc::detail::append_uint8;
+
 // Mutable, currently set Traits & Colors. Yes, they are global to this TU.
 auto current_traits = esc::Traits{esc::Trait::None};
 auto current_background = esc::Color{esc::TermColor::Default};
 auto current_foreground = esc::Color{esc::TermColor::Default};
 
 /**
- * Translate a single Trait into its control sequence parameter integer.
- * @details Returns empty string for Trait::None.
- * @param t The Trait to translate.
- * @return The control sequence parameter int as string.
- * @throws std::runtime_error If the Trait is invalid.
+ * Replace Trait::Standout in \p traits with the Traits it is made of.
+ * @param traits The Traits to expand.
+ * @return \p traits with Trait::Standout replaced by Trait::Bold and Trait::Inverse.
  */
-auto trait_to_int_sequence(esc::Trait t) -> std::string
+[[nodiscard]] auto expand_standout(esc::Traits traits) -> esc::Traits
 {
     using esc::Trait;
-    switch (t) {
-        case Trait::Standout:
-            return trait_to_int_sequence(Trait::Bold) + ';' +
-                   trait_to_int_sequence(Trait::Inverse);
-        case Trait::None: return "";
-        case Trait::Bold: return "1";
-        case Trait::Dim: return "2";
-        case Trait::Italic: return "3";
-        case Trait::Underline: return "4";
-        case Trait::Blink: return "5";
-        case Trait::Inverse: return "7";
-        case Trait::Invisible: return "8";
-        case Trait::CrossedOut: return "9";
-        case Trait::DoubleUnderline: return "21";
+    if (traits.contains(Trait::Standout)) {
+        traits.remove(Trait::Standout).insert(Trait::Bold).insert(Trait::Inverse);
+    }
+    return traits;
+}
+
+/**
+ * Append the SGR parameters to set \p c to \p out, preceded by a semi-colon.
+ * @details The first 16 palette colors use their shorter 3/4/9/10 forms, the same as
+ * the setaf/setab terminfo capabilities.
+ * @param out        The string to append to.
+ * @param c          The Color to set.
+ * @param foreground True to set the foreground color, false for the background.
+ */
+void append_color_params(std::string& out, esc::Color const& c, bool foreground)
+{
+    std::visit(
+        [&](auto c) {
+            using T = std::decay_t<decltype(c)>;
+            out.push_back(';');
+            if constexpr (std::is_same_v<T, esc::XColor>) {
+                if (c.value < 8) {
+                    ::append_int(out, (foreground ? 30 : 40) + c.value);
+                }
+                else if (c.value < 16) {
+                    ::append_int(out, (foreground ? 90 : 100) + c.value - 8);
+                }
+                else {
+                    out.append(foreground ? "38;5;" : "48;5;");
+                    ::append_uint8(out, c.value);
+                }
+            }
+            else if constexpr (std::is_same_v<T, esc::TrueColor>) {
+                out.append(foreground ? "38;2;" : "48;2;");
+                ::append_rgb(out, c);
+            }
+            else {
+                out.append(foreground ? "39" : "49");
+            }
+        },
+        c);
+}
+
+/**
+ * Append the SGR parameters to set \p b from a reset state, preceded by a semi-colon.
+ * @param out The string to append to.
+ * @param b   The Brush to set.
+ */
+void append_brush_params(std::string& out, esc::Brush const& b)
+{
+    auto constexpr default_color = esc::Color{esc::TermColor::Default};
+    out.append(";0");
+    ::append_traits(out, ::expand_standout(b.traits));
+    if (b.background != default_color) {
+        ::append_color_params(out, b.background, false);
+    }
+    if (b.foreground != default_color) {
+        ::append_color_params(out, b.foreground, true);
     }
-    throw std::runtime_error{"traits_to_int_sequence: Invalid Trait Value"};
 }
 
 /**
- * Turn a mask of traits into a string control sequence of parameter integers.
- * @param traits The traits to translate.
- * @return The control sequence parameter integers as a string.
- * @throws std::logic_error If a Trait is invalid.
+ * Append the SGR parameters to change from \p from to \p to, each parameter preceded
+ * by a semi-colon.
+ * @details Some Traits share a reset parameter, Traits that are kept but share a reset
+ * with a removed Trait are set again.
+ * @param out  The string to append to.
+ * @param from The Brush that is currently set.
+ * @param to   The Brush to set.
  */
-auto traits_to_int_sequence(esc::Traits traits) -> std::string
+void append_brush_delta_params(std::string& out,
+                               esc::Brush const& from,
+                               esc::Brush const& to)
 {
     using esc::Trait;
-    auto constexpr last_trait = 512;
+    using esc::Traits;
 
-    auto result = std::string{};
-    for (auto i = std::underlying_type_t<Trait>{1}; i <= last_trait; i <<= 1) {
-        if (auto const t = static_cast<Trait>(i); traits.contains(t)) {
-            result.append(trait_to_int_sequence(t));
-            result.push_back(';');
+    struct Reset {
+        Traits traits;
+        std::string_view parameter;
+    };
+    static auto const resets = std::array{
+        Reset{Trait::Bold | Trait::Dim, "22"},
+        Reset{Trait::Italic, "23"},
+        Reset{Trait::Underline | Trait::DoubleUnderline, "24"},
+        Reset{Trait::Blink, "25"},
+        Reset{Trait::Inverse, "27"},
+        Reset{Trait::Invisible, "28"},
+        Reset{Trait::CrossedOut, "29"},
+    };
+
+    auto const from_traits = ::expand_standout(from.traits);
+    auto const to_traits = ::expand_standout(to.traits);
+
+    auto added = to_traits;
+    added.remove(from_traits);
+    for (auto const& reset : resets) {
+        auto removed = reset.traits;
+        removed.remove(to_traits);
+        if (from_traits.data() & removed.data()) {
+            out.push_back(';');
+            out.append(reset.parameter);
+            added.insert(Traits{reset.traits}.remove(removed));
         }
     }
-    if (!result.empty()) {
-        result.pop_back();  // Remove last semi-colon.
+    ::append_traits(out, added);
+
+    if (from.background != to.background) {
+        ::append_color_params(out, to.background, false);
     }
-    return result;
+    if (from.foreground != to.foreground) {
+        ::append_color_params(out, to.foreground, true);
+    }
+}
+
+/**
+ * Return the number of decimal digits in \p n.
+ * @param n The non-negative integer to count the digits of.
+ * @return The number of decimal digits in \p n.
+ */
+[[nodiscard]] auto digit_count(int n) -> std::size_t
+{
+    auto count = std::size_t{1};
+    for (; n >= 10; n /= 10) {
+        ++count;
+    }
+    return count;
+}
+
+/**
+ * Cursor movement encodings, see CursorTracker.
+ */
+enum class Move { None, CR, BS, CUU, CUD, CUF, CUB, CHA, VPA };
+
+/**
+ * A single cursor movement and its cost in bytes.
+ */
+struct Step {
+    Move move = Move::None;
+    int n = 0;
+    std::size_t cost = 0;
+};
+
+/**
+ * Cost of a control sequence with a single parameter that defaults to one.
+ * @param n The parameter value.
+ * @return The number of bytes in the control sequence, the parameter is left out if 1.
+ */
+[[nodiscard]] auto default_one_cost(int n) -> std::size_t
+{
+    return 3 + (n == 1 ? 0 : ::digit_count(n));
+}
+
+/**
+ * Return the cheaper of two Steps, \p a on ties.
+ */
+[[nodiscard]] auto cheaper(Step a, Step b) -> Step { return b.cost < a.cost ? b : a; }
+
+/**
+ * Cheapest Step to move the cursor vertically from \p from to \p to.
+ */
+[[nodiscard]] auto vertical_step(int from, int to) -> Step
+{
+    if (from == to) {
+        return {};
+    }
+    auto const vpa = Step{Move::VPA, to + 1, ::default_one_cost(to + 1)};
+    if (to < from) {
+        return ::cheaper({Move::CUU, from - to, ::default_one_cost(from - to)}, vpa);
+    }
+    return ::cheaper({Move::CUD, to - from, ::default_one_cost(to - from)}, vpa);
+}
+
+/**
+ * Cheapest Step to move the cursor horizontally from \p from to \p to.
+ */
+[[nodiscard]] auto horizontal_step(int from, int to) -> Step
+{
+    if (from == to) {
+        return {};
+    }
+    if (to == 0) {
+        return {Move::CR, 0, 1};
+    }
+    auto const cha = Step{Move::CHA, to + 1, ::default_one_cost(to + 1)};
+    if (to < from) {
+        auto const back = ::cheaper(
+            {Move::BS, from - to, static_cast<std::size_t>(from - to)},
+            {Move::CUB, from - to, ::default_one_cost(from - to)});
+        return ::cheaper(back, cha);
+    }
+    return ::cheaper({Move::CUF, to - from, ::default_one_cost(to - from)}, cha);
+}
+
+/**
+ * Append the bytes for \p step to \p out.
+ */
+void append_step(std::string& out, Step step)
+{
+    auto const csi = [&](char final_byte) {
+        out.append("\033[");
+        if (step.n != 1) {
+            ::append_int(out, step.n);
+        }
+        out.push_back(final_byte);
+    };
+    switch (step.move) {
+        case Move::None: break;
+        case Move::CR: out.push_back('\r'); break;
+        case Move::BS: out.append(static_cast<std::size_t>(step.n), '\b'); break;
+        case Move::CUU: csi('A'); break;
+        case Move::CUD: csi('B'); break;
+        case Move::CUF: csi('C'); break;
+        case Move::CUB: csi('D'); break;
+        case Move::CHA: csi('G'); break;
+        case Move::VPA: csi('d'); break;
+    }
+}
+
+/**
+ * Cost of a CUP to \p p, parameters of one are left out.
+ */
+[[nodiscard]] auto cup_cost(esc::Point p) -> std::size_t
+{
+    if (p.x == 0) {
+        return ::default_one_cost(p.y + 1);
+    }
+    return 4 + (p.y == 0 ? 0 : ::digit_count(p.y + 1)) + ::digit_count(p.x + 1);
+}
+
+/**
+ * Append a CUP to \p p to \p out, parameters of one are left out.
+ */
+void append_cup(std::string& out, esc::Point p)
+{
+    out.append("\033[");
+    if (p.y != 0) {
+        ::append_int(out, p.y + 1);
+    }
+    if (p.x != 0) {
+        out.push_back(';');
+        ::append_int(out, p.x + 1);
+    }
+    out.push_back('H');
+}
+
+/**
+ * Cursor moves, in the order they are applied. CR + LF moves are a CR Step followed by
+ * a number of line feeds.
+ */
+struct Plan {
+    bool is_cup = false;
+    Step first = {};
+    int line_feeds = 0;
+    Step second = {};
+    std::size_t cost = 0;
+};
+
+/**
+ * Find the cheapest way to move the cursor from \p from to \p to.
+ * @param from The current cursor position, or std::nullopt if unknown.
+ * @param to   The Point to move to.
+ * @return The cheapest Plan.
+ */
+[[nodiscard]] auto plan_move(std::optional<esc::Point> from, esc::Point to) -> Plan
+{
+    auto best = Plan{.is_cup = true, .cost = ::cup_cost(to)};
+    if (!from.has_value()) {
+        return best;
+    }
+    auto const consider = [&best](Plan p) {
+        if (p.cost < best.cost) {
+            best = p;
+        }
+    };
+
+    // Independent vertical and horizontal moves.
+    {
+        auto const v = ::vertical_step(from->y, to.y);
+        auto const h = ::horizontal_step(from->x, to.x);
+        consider({.first = v, .second = h, .cost = v.cost + h.cost});
+    }
+
+    // CR, then LF for each row down, then move right from the first column. LF can
+    // only scroll on the last row, which can't be above the target row.
+    if (auto const rows = to.y - from->y; rows > 0) {
+        auto const h = ::horizontal_step(0, to.x);
+        consider({
+            .first = {Move::CR, 0, 1},
+            .line_feeds = rows,
+            .second = h,
+            .cost = 1 + static_cast<std::size_t>(rows) + h.cost,
+        });
+    }
+    return best;
 }
 
 }  // namespace
 
 namespace esc {
 
+void escape_to(std::string& out, Cursor p) { detail::append_escape(out, p); }
+
 auto escape(Cursor p) -> std::string
 {
-    return "\033[" + std::to_string(p.y + 1) + ';' + std::to_string(p.x + 1) + 'H';
+    auto result = std::string{};
+    escape_to(result, p);
+    return result;
 }
 
-auto escape(BlankRow) -> std::string
+void escape_to(std::string& out, BlankRow x) { detail::append_escape(out, x); }
+
+void CursorTracker::escape_to(std::string& out, Cursor p)
 {
-    return "\033["
-           "2K";
+    auto const plan = ::plan_move(at_, p);
+    if (plan.is_cup) {
+        ::append_cup(out, p);
+    }
+    else {
+        ::append_step(out, plan.first);
+        out.append(static_cast<std::size_t>(plan.line_feeds), '\n');
+        ::append_step(out, plan.second);
+    }
+    at_ = p;
 }
 
-auto escape(BlankScreen) -> std::string
+auto CursorTracker::escape(Cursor p) -> std::string
 {
-    return "\033["
-           "2J";
+    auto result = std::string{};
+    this->escape_to(result, p);
+    return result;
 }
 
-auto escape(Traits traits) -> std::string
+auto CursorTracker::cost(Cursor p) const -> std::size_t
 {
-    ::current_traits = traits;
-    if (traits.data() == 0) {  // Trait::None
-        // Clear Traits
-        return "\033["
-               "22;23;24;25;27;28;29m";
-    }
-    else {
-        return "\033["
-               "22;23;24;25;27;28;29;" +
-               ::traits_to_int_sequence(traits) + 'm';
+    return ::plan_move(at_, p).cost;
+}
+
+void CursorTracker::advance(int cells)
+{
+    if (at_.has_value()) {
+        at_->x += cells;
     }
 }
 
-auto escape(Trait trait) -> std::string { return escape(Traits{trait}); }
+void CursorTracker::invalidate() { at_ = std::nullopt; }
 
-auto clear_traits() -> std::string
+auto CursorTracker::cursor() const -> std::optional<Cursor> { return at_; }
+
+auto escape(BlankRow x) -> std::string
 {
-    ::current_traits = Traits{};
-    return "\033["
-           "22;23;24;25;27;28;29m";
+    auto result = std::string{};
+    escape_to(result, x);
+    return result;
 }
 
+void escape_to(std::string& out, BlankScreen x) { detail::append_escape(out, x); }
+
+auto escape(BlankScreen x) -> std::string
+{
+    auto result = std::string{};
+    escape_to(result, x);
+    return result;
+}
+
+void escape_to(std::string& out, Traits traits)
+{
+    ::current_traits = traits;
+    detail::append_escape(out, traits);
+}
+
+auto escape(Traits traits) -> std::string
+{
+    auto result = std::string{};
+    escape_to(result, traits);
+    return result;
+}
+
+void escape_to(std::string& out, Trait trait) { escape_to(out, Traits{trait}); }
+
+auto escape(Trait trait) -> std::string { return escape(Traits{trait}); }
+
+auto clear_traits() -> std::string { return escape(Traits{}); }
+
 auto traits() -> Traits { return ::current_traits; }
 
+void escape_to(std::string& out, ColorBG c)
+{
+    std::visit([&out](auto c) { escape_bg_to(out, c); }, c.value);
+}
+
 auto escape(ColorBG c) -> std::string
 {
-    return std::visit([](auto c) { return escape_bg(c); }, c.value);
+    auto result = std::string{};
+    escape_to(result, c);
+    return result;
+}
+
+void escape_bg_to(std::string& out, XColor c)
+{
+    ::current_background = c;
+    detail::append_escape_bg(out, c);
 }
 
 auto escape_bg(XColor c) -> std::string
+{
+    auto result = std::string{};
+    escape_bg_to(result, c);
+    return result;
+}
+
+void escape_bg_to(std::string& out, TrueColor c)
 {
     ::current_background = c;
-    return "\033["
-           "48;5;" +
-           std::to_string(c.value) + 'm';
+    detail::append_escape_bg(out, c);
 }
 
 auto escape_bg(TrueColor c) -> std::string
+{
+    auto result = std::string{};
+    escape_bg_to(result, c);
+    return result;
+}
+
+void escape_bg_to(std::string& out, TermColor c)
 {
     ::current_background = c;
-    return "\033["
-           "48;2;" +
-           std::to_string(c.red) + ';' + std::to_string(c.green) + ';' +
-           std::to_string(c.blue) + 'm';
+    detail::append_escape_bg(out, c);
 }
 
 auto escape_bg(TermColor c) -> std::string
 {
-    ::current_background = c;
-    return "\033["
-           "49m";
+    auto result = std::string{};
+    escape_bg_to(result, c);
+    return result;
 }
 
 auto background_color() -> Color { return ::current_background; }
 
+void escape_to(std::string& out, ColorFG c)
+{
+    std::visit([&out](auto c) { escape_fg_to(out, c); }, c.value);
+}
+
 auto escape(ColorFG c) -> std::string
 {
-    return std::visit([](auto c) { return escape_fg(c); }, c.value);
+    auto result = std::string{};
+    escape_to(result, c);
+    return result;
+}
+
+void escape_fg_to(std::string& out, XColor c)
+{
+    ::current_foreground = c;
+    detail::append_escape_fg(out, c);
 }
 
 auto escape_fg(XColor c) -> std::string
+{
+    auto result = std::string{};
+    escape_fg_to(result, c);
+    return result;
+}
+
+void escape_fg_to(std::string& out, TrueColor c)
 {
     ::current_foreground = c;
-    return "\033["
-           "38;5;" +
-           std::to_string(c.value) + 'm';
+    detail::append_escape_fg(out, c);
 }
 
 auto escape_fg(TrueColor c) -> std::string
+{
+    auto result = std::string{};
+    escape_fg_to(result, c);
+    return result;
+}
+
+void escape_fg_to(std::string& out, TermColor c)
 {
     ::current_foreground = c;
-    return "\033["
-           "38;2;" +
-           std::to_string(c.red) + ';' + std::to_string(c.green) + ';' +
-           std::to_string(c.blue) + 'm';
+    detail::append_escape_fg(out, c);
 }
 
 auto escape_fg(TermColor c) -> std::string
 {
-    ::current_foreground = c;
-    return "\033["
-           "39m";
+    auto result = std::string{};
+    escape_fg_to(result, c);
+    return result;
 }
 
 auto foreground_color() -> Color { return ::current_foreground; }
 
+void escape_to(std::string& out, Brush b)
+{
+    escape_to(out, bg(b.background));
+    escape_to(out, fg(b.foreground));
+    escape_to(out, b.traits);
+}
+
 auto escape(Brush b) -> std::string
 {
-    return escape(bg(b.background)) + escape(fg(b.foreground)) + escape(b.traits);
+    auto result = std::string{};
+    escape_to(result, b);
+    return result;
+}
+
+void BrushTracker::escape_to(std::string& out, Brush const& b)
+{
+    if (brush_ == b) {
+        return;
+    }
+
+    // Parameters are appended with a leading semi-colon, the first is dropped.
+    auto const begin = out.size();
+    out.append("\033[");
+    auto const params_begin = out.size();
+    if (brush_.has_value()) {
+        ::append_brush_delta_params(out, *brush_, b);
+        auto const delta_end = out.size();
+        if (delta_end == params_begin) {  // Same attributes, e.g. Standout vs Bold.
+            out.resize(begin);
+            brush_ = b;
+            return;
+        }
+
+        // A full reset can be shorter, e.g. when many Traits are removed.
+        ::append_brush_params(out, b);
+        if (out.size() - delta_end < delta_end - params_begin) {
+            out.erase(params_begin, delta_end - params_begin);
+        }
+        else {
+            out.resize(delta_end);
+        }
+    }
+    else {
+        ::append_brush_params(out, b);
+    }
+    out.erase(params_begin, 1);
+    out.push_back('m');
+    brush_ = b;
+}
+
+auto BrushTracker::escape(Brush const& b) -> std::string
+{
+    auto result = std::string{};
+    this->escape_to(result, b);
+    return result;
 }
 
+void BrushTracker::invalidate() { brush_ = std::nullopt; }
+
+auto BrushTracker::brush() const -> std::optional<Brush> { return brush_; }
+
 }  // namespace esc
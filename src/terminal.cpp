@@ -1,17 +1,22 @@
 #include <esc/terminal.hpp>
 
+#include <chrono>
+#include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
 #include <string>
-#include <utility>
 
 #include <sys/ioctl.h>
 #include <termios.h>
 #include <unistd.h>
 
+#include <esc/capabilities.hpp>
+#include <esc/detail/capability_cache.hpp>
 #include <esc/detail/console_file.hpp>
 #include <esc/detail/is_urxvt.hpp>
+#include <esc/detail/query.hpp>
 #include <esc/detail/signals.hpp>
 #include <esc/detail/tty_file.hpp>
 #include <esc/io.hpp>
@@ -27,11 +32,55 @@ namespace {
     return current;
 }
 
-void fix_ctrl_m()
+/**
+ * Apply \p settings on top of \p base with a single tcsetattr().
+ * @details TCSANOW keeps input that was typed ahead, TCSAFLUSH would discard it.
+ * @param settings   The settings to change, the rest of \p base is kept.
+ * @param base       The termios to start from.
+ * @param fix_ctrl_m If true, stop translating carriage return to newline on input, so
+ *                   Enter and ctrl-m can be read as themselves.
+ */
+void apply_termios(esc::detail::TermiosSettings const& settings,
+                   ::termios base,
+                   bool fix_ctrl_m = false)
 {
-    auto settings = current_termios();
-    settings.c_iflag &= ~(ICRNL);
-    ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &settings);
+    using esc::Echo;
+    using esc::InputBuffer;
+    using esc::Signals;
+
+    if (settings.echo.has_value()) {
+        if (*settings.echo == Echo::On) {
+            base.c_lflag |= ECHO;
+        }
+        else {
+            base.c_lflag &= ~ECHO;
+        }
+    }
+    if (settings.input_buffer.has_value()) {
+        if (*settings.input_buffer == InputBuffer::Canonical) {
+            base.c_lflag |= ICANON;
+        }
+        else {
+            base.c_lflag &= ~ICANON;
+            base.c_cc[VMIN] = 1;  // Min. number of bytes before sending.
+        }
+    }
+    if (settings.signals.has_value()) {
+        // ctrl-c, ctrl-z, ctrl-s, ctrl-q, ctrl-v all send their ctrl byte value rather
+        // than changing the terminal's behaviour.
+        if (*settings.signals == Signals::On) {
+            base.c_lflag |= ISIG | IEXTEN;
+            base.c_iflag |= IXON;
+        }
+        else {
+            base.c_lflag &= ~(ISIG | IEXTEN);
+            base.c_iflag &= ~IXON;
+        }
+    }
+    if (fix_ctrl_m) {
+        base.c_iflag &= ~ICRNL;
+    }
+    ::tcsetattr(STDIN_FILENO, TCSANOW, &base);
 }
 
 [[nodiscard]] auto turn_off_auto_wrap() -> std::string { return "\033[?7l"; }
@@ -44,43 +93,11 @@ auto original_termios = ::termios{};
 
 namespace esc {
 
-void set(Echo x)
-{
-    auto const echo_flag = (x == Echo::On) ? ECHO : ~ECHO;
+void set(Echo x) { detail::set_termios({.echo = x}); }
 
-    auto settings = current_termios();
-    settings.c_lflag &= echo_flag;
-    ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &settings);
-}
+void set(InputBuffer x) { detail::set_termios({.input_buffer = x}); }
 
-void set(InputBuffer x)
-{
-    auto const canon_flag = (x == InputBuffer::Canonical) ? ICANON : ~(ICANON);
-
-    auto settings = current_termios();
-    settings.c_lflag &= canon_flag;
-    if (x == InputBuffer::Immediate) {
-        settings.c_cc[VMIN] = 1;  // Min. number of bytes before sending.
-    }
-    ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &settings);
-}
-
-void set(Signals x)
-{
-    // ctrl-c, ctrl-z, ctrl-s, ctrl-q, ctrl-v all send their ctrl byte value rather than
-    // changing the terminal's behaviour.
-    auto const [lflags, iflags] = [x] {
-        auto const lflags = ISIG | IEXTEN;
-        auto const iflags = IXON;
-        return (x == Signals::On) ? std::pair{lflags, iflags}
-                                  : std::pair{~lflags, ~iflags};
-    }();
-
-    auto settings = current_termios();
-    settings.c_lflag &= lflags;
-    settings.c_iflag &= iflags;
-    ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &settings);
-}
+void set(Signals x) { detail::set_termios({.signals = x}); }
 
 void set(ScreenBuffer x)
 {
@@ -136,7 +153,9 @@ void set(CursorMode x)
 
 void set(MouseMode x)
 {
-    auto const ext_mode = detail::is_urxvt(TERM_var()) ? "1015" : "1006";
+    // urxvt has its own extended mode, used unless it reported SGR mouse support.
+    auto const ext_mode =
+        capabilities().sgr_mouse || !detail::is_urxvt(TERM_var()) ? "1006" : "1015";
 
     auto result = std::string{};
     switch (x) {
@@ -168,20 +187,25 @@ void initialize_terminal(ScreenBuffer screen_buffer,
                          KeyMode key_mode,
                          bool sigint_uninit)
 {
-    auto constexpr stdout_buf_size = 4'096;
     // TODO record current settings before calling set, this is ioctl things and
     // tcsetaddr things. termios? probably from tcsetaddr
 
     original_termios = current_termios();
 
-    std::setvbuf(stdout, nullptr, _IOFBF, stdout_buf_size);
     detail::register_signals(sigint_uninit);
 
-    fix_ctrl_m();
+    // One tcsetattr() for every termios change, from the settings just read.
+    ::apply_termios({.echo = echo, .input_buffer = input_buffer, .signals = signals},
+                    original_termios, true);
     write(turn_off_auto_wrap());
 
+    // Before set(), so set(MouseMode) can use what the terminal reports.
+    auto constexpr probe_budget = std::chrono::milliseconds{100};
+    detail::probed_capabilities = detail::cached_capabilities(
+        probe_budget, echo == Echo::Off && input_buffer == InputBuffer::Immediate);
+
     try {
-        set(echo, input_buffer, signals, screen_buffer, mouse_mode, cursor, key_mode);
+        set(screen_buffer, mouse_mode, cursor, key_mode);
     }
     catch (std::runtime_error const& e) {
         uninitialize_terminal();
@@ -212,6 +236,7 @@ void uninitialize_terminal()
     write(turn_on_auto_wrap());
     set(ScreenBuffer::Normal, MouseMode::Off, CursorMode::Show, KeyMode::Normal);
     flush();
+    detail::drain_probe_replies(std::chrono::milliseconds{100});
     ::tcsetattr(STDIN_FILENO, TCSAFLUSH, &original_termios);
     if (detail::tty_file_descriptor.has_value()) {
         close(detail::tty_file_descriptor.value());
@@ -242,10 +267,40 @@ auto terminal_height() -> int
 
 auto terminal_area() -> Area
 {
+    auto w = ::winsize{};
+    auto const result = ::ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+    if (result == -1) {
+        throw std::runtime_error{
+            "terminal.cpp terminal_area(): Can't Read Window Size."};
+    }
     return {
-        .width = terminal_width(),
-        .height = terminal_height(),
+        .width = w.ws_col,
+        .height = w.ws_row,
     };
 }
 
+auto cached_terminal_area() -> Area
+{
+    static auto area = std::optional<Area>{};
+    static auto resize_count = std::sig_atomic_t{0};
+    if (!area.has_value() || resize_count != detail::window_resize_count) {
+        resize_count = detail::window_resize_count;
+        area = terminal_area();
+    }
+    return *area;
+}
+
 }  // namespace esc
+
+namespace esc::detail {
+
+void set_termios(TermiosSettings const& settings)
+{
+    if (!settings.echo.has_value() && !settings.input_buffer.has_value() &&
+        !settings.signals.has_value()) {
+        return;
+    }
+    ::apply_termios(settings, current_termios());
+}
+
+}  // namespace esc::detail
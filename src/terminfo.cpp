@@ -2,12 +2,26 @@
 
 #include <algorithm>
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <iterator>
-#include <stdexcept>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <esc/capabilities.hpp>
 
 namespace {
 
@@ -16,174 +30,179 @@ namespace {
  * @details Currently just color_palette_size. Was going to contain supported mouse
  * modes, but terminfo doesn't seem to have that.
  */
-struct Terminfo {
+struct TerminfoEntry {
     std::string_view TERM_name;
     std::uint16_t color_palette_size;
 };
 
 /**
- * Small database of term names and color counts.
+ * Small database of term names and color counts, sorted by TERM_name.
  * @details Generated with tools/terminfo.sh
  */
-inline auto const terminfo_db = std::array<Terminfo, 140>{
-    Terminfo{"xterm-256color", 256},
-    Terminfo{"tmux-256color", 256},
-    Terminfo{"tmux", 8},
-    Terminfo{"cygwin", 8},
-    Terminfo{"putty", 8},
-    Terminfo{"putty-256color", 256},
-    Terminfo{"linux", 8},
-    Terminfo{"vte-256color", 256},
-    Terminfo{"konsole", 8},
-    Terminfo{"konsole-256color", 256},
-    Terminfo{"kitty", 256},
-    Terminfo{"xterm-kitty", 256},
-    Terminfo{"Apple_Terminal", 256},
-    Terminfo{"rxvt-unicode", 88},
-    Terminfo{"rxvt-unicode-256color", 256},
-    Terminfo{"rxvt-256color", 256},
-    Terminfo{"teraterm2.3", 8},
-    Terminfo{"teraterm", 8},
-    Terminfo{"xterm-xf86-v40", 8},
-    Terminfo{"xterm-noapp", 8},
-    Terminfo{"xterm-24", 8},
-    Terminfo{"xterm-88color", 88},
-    Terminfo{"xterm-r5", 8},
-    Terminfo{"xterm-xf86-v33", 8},
-    Terminfo{"xterm-hp", 8},
-    Terminfo{"xterm-x11hilite", 8},
-    Terminfo{"xterm-xf86-v44", 8},
-    Terminfo{"xterm-pcolor", 8},
-    Terminfo{"xterm-xfree86", 8},
-    Terminfo{"xterm-xf86-v333", 8},
-    Terminfo{"xterm-direct2", 256},
-    Terminfo{"xterm-xf86-v43", 8},
-    Terminfo{"xterm-xi", 8},
-    Terminfo{"xterm-sun", 8},
-    Terminfo{"xterm-1005", 8},
-    Terminfo{"xterm-utf8", 8},
-    Terminfo{"xterm-1006", 8},
-    Terminfo{"xterm-x10mouse", 8},
-    Terminfo{"xterm-1002", 8},
-    Terminfo{"xterm-8bit", 8},
-    Terminfo{"xterm-vt220", 8},
-    Terminfo{"xterm", 8},
-    Terminfo{"xterm-bold", 8},
-    Terminfo{"xterm-direct", 256},
-    Terminfo{"xterm-16color", 16},
-    Terminfo{"xterm-color", 8},
-    Terminfo{"xterm-r6", 8},
-    Terminfo{"xterms", 8},
-    Terminfo{"xterm-old", 8},
-    Terminfo{"xterm-x11mouse", 8},
-    Terminfo{"xfce", 8},
-    Terminfo{"xterm-new", 8},
-    Terminfo{"xterm-sco", 8},
-    Terminfo{"xterm-mono", 8},
-    Terminfo{"xterm-nic", 8},
-    Terminfo{"xterm-1003", 8},
-    Terminfo{"xterm-vt52", 8},
-    Terminfo{"xterm-basic", 8},
-    Terminfo{"xterm-xf86-v32", 8},
-    Terminfo{"screen.konsole-256color", 256},
-    Terminfo{"screen-256color", 256},
-    Terminfo{"screen.Eterm", 8},
-    Terminfo{"screen.linux", 8},
-    Terminfo{"screen.putty", 8},
-    Terminfo{"screen.vte-256color", 256},
-    Terminfo{"screen.xterm-r6", 8},
-    Terminfo{"st-16color", 16},
-    Terminfo{"sun1", 8},
-    Terminfo{"sun2", 8},
-    Terminfo{"stterm-256color", 256},
-    Terminfo{"screen.mlterm-256color", 256},
-    Terminfo{"screen.vte", 8},
-    Terminfo{"screen.gnome", 8},
-    Terminfo{"screen.putty-256color", 256},
-    Terminfo{"screen.xterm-new", 8},
-    Terminfo{"stterm-16color", 16},
-    Terminfo{"screen-16color", 16},
-    Terminfo{"screen.xterm-256color", 256},
-    Terminfo{"screen.konsole", 8},
-    Terminfo{"st", 8},
-    Terminfo{"screen", 8},
-    Terminfo{"screen.rxvt", 8},
-    Terminfo{"screen.teraterm", 8},
-    Terminfo{"screen.xterm-xfree86", 8},
-    Terminfo{"stterm", 8},
-    Terminfo{"screen.mlterm", 8},
-    Terminfo{"st-256color", 256},
-    Terminfo{"screen.mrxvt", 8},
-    Terminfo{"sun", 8},
-    Terminfo{"mach", 8},
-    Terminfo{"mach-bold", 8},
-    Terminfo{"mlterm", 8},
-    Terminfo{"mach-color", 8},
-    Terminfo{"mach-gnu", 8},
-    Terminfo{"mach-gnu-color", 8},
-    Terminfo{"mrxvt", 8},
-    Terminfo{"gnome-256color", 256},
-    Terminfo{"gnome", 8},
-    Terminfo{"Eterm-88color", 88},
-    Terminfo{"Eterm-256color", 256},
-    Terminfo{"Eterm-color", 8},
-    Terminfo{"Eterm", 8},
-    Terminfo{"dumb", 8},
-    Terminfo{"rxvt-cygwin", 8},
-    Terminfo{"rxvt-color", 8},
-    Terminfo{"rxvt", 8},
-    Terminfo{"rxvt-basic", 8},
-    Terminfo{"rxvt-xpm", 8},
-    Terminfo{"rxvt-cygwin-native", 8},
-    Terminfo{"rxvt-16color", 16},
-    Terminfo{"rxvt-88color", 88},
-    Terminfo{"nsterm", 256},
-    Terminfo{"nsterm-256color", 256},
-    Terminfo{"nxterm", 8},
-    Terminfo{"aterm", 8},
-    Terminfo{"ansis", 8},
-    Terminfo{"ansi", 8},
-    Terminfo{"alacritty", 256},
-    Terminfo{"ansi80x25", 8},
-    Terminfo{"hurd", 8},
-    Terminfo{"kon2", 8},
-    Terminfo{"kon", 8},
-    Terminfo{"vt100-nav", 8},
-    Terminfo{"vs100", 8},
-    Terminfo{"vt52", 8},
-    Terminfo{"vt200", 8},
-    Terminfo{"vte", 8},
-    Terminfo{"vwmterm", 8},
-    Terminfo{"vt100-am", 8},
-    Terminfo{"vt102", 8},
-    Terminfo{"vt100", 8},
-    Terminfo{"vt220", 8},
-    Terminfo{"jfbterm", 8},
-    Terminfo{"eterm-color", 8},
-    Terminfo{"eterm", 8},
-    Terminfo{"wsvt25m", 8},
-    Terminfo{"wsvt25", 8},
-    Terminfo{"pcansi", 8},
-    Terminfo{"bterm", 8},
-    Terminfo{"cons25", 8},
+constexpr auto terminfo_db = std::array<TerminfoEntry, 140>{
+    TerminfoEntry{"Apple_Terminal", 256},
+    TerminfoEntry{"Eterm", 8},
+    TerminfoEntry{"Eterm-256color", 256},
+    TerminfoEntry{"Eterm-88color", 88},
+    TerminfoEntry{"Eterm-color", 8},
+    TerminfoEntry{"alacritty", 256},
+    TerminfoEntry{"ansi", 8},
+    TerminfoEntry{"ansi80x25", 8},
+    TerminfoEntry{"ansis", 8},
+    TerminfoEntry{"aterm", 8},
+    TerminfoEntry{"bterm", 8},
+    TerminfoEntry{"cons25", 8},
+    TerminfoEntry{"cygwin", 8},
+    TerminfoEntry{"dumb", 8},
+    TerminfoEntry{"eterm", 8},
+    TerminfoEntry{"eterm-color", 8},
+    TerminfoEntry{"gnome", 8},
+    TerminfoEntry{"gnome-256color", 256},
+    TerminfoEntry{"hurd", 8},
+    TerminfoEntry{"jfbterm", 8},
+    TerminfoEntry{"kitty", 256},
+    TerminfoEntry{"kon", 8},
+    TerminfoEntry{"kon2", 8},
+    TerminfoEntry{"konsole", 8},
+    TerminfoEntry{"konsole-256color", 256},
+    TerminfoEntry{"linux", 8},
+    TerminfoEntry{"mach", 8},
+    TerminfoEntry{"mach-bold", 8},
+    TerminfoEntry{"mach-color", 8},
+    TerminfoEntry{"mach-gnu", 8},
+    TerminfoEntry{"mach-gnu-color", 8},
+    TerminfoEntry{"mlterm", 8},
+    TerminfoEntry{"mrxvt", 8},
+    TerminfoEntry{"nsterm", 256},
+    TerminfoEntry{"nsterm-256color", 256},
+    TerminfoEntry{"nxterm", 8},
+    TerminfoEntry{"pcansi", 8},
+    TerminfoEntry{"putty", 8},
+    TerminfoEntry{"putty-256color", 256},
+    TerminfoEntry{"rxvt", 8},
+    TerminfoEntry{"rxvt-16color", 16},
+    TerminfoEntry{"rxvt-256color", 256},
+    TerminfoEntry{"rxvt-88color", 88},
+    TerminfoEntry{"rxvt-basic", 8},
+    TerminfoEntry{"rxvt-color", 8},
+    TerminfoEntry{"rxvt-cygwin", 8},
+    TerminfoEntry{"rxvt-cygwin-native", 8},
+    TerminfoEntry{"rxvt-unicode", 88},
+    TerminfoEntry{"rxvt-unicode-256color", 256},
+    TerminfoEntry{"rxvt-xpm", 8},
+    TerminfoEntry{"screen", 8},
+    TerminfoEntry{"screen-16color", 16},
+    TerminfoEntry{"screen-256color", 256},
+    TerminfoEntry{"screen.Eterm", 8},
+    TerminfoEntry{"screen.gnome", 8},
+    TerminfoEntry{"screen.konsole", 8},
+    TerminfoEntry{"screen.konsole-256color", 256},
+    TerminfoEntry{"screen.linux", 8},
+    TerminfoEntry{"screen.mlterm", 8},
+    TerminfoEntry{"screen.mlterm-256color", 256},
+    TerminfoEntry{"screen.mrxvt", 8},
+    TerminfoEntry{"screen.putty", 8},
+    TerminfoEntry{"screen.putty-256color", 256},
+    TerminfoEntry{"screen.rxvt", 8},
+    TerminfoEntry{"screen.teraterm", 8},
+    TerminfoEntry{"screen.vte", 8},
+    TerminfoEntry{"screen.vte-256color", 256},
+    TerminfoEntry{"screen.xterm-256color", 256},
+    TerminfoEntry{"screen.xterm-new", 8},
+    TerminfoEntry{"screen.xterm-r6", 8},
+    TerminfoEntry{"screen.xterm-xfree86", 8},
+    TerminfoEntry{"st", 8},
+    TerminfoEntry{"st-16color", 16},
+    TerminfoEntry{"st-256color", 256},
+    TerminfoEntry{"stterm", 8},
+    TerminfoEntry{"stterm-16color", 16},
+    TerminfoEntry{"stterm-256color", 256},
+    TerminfoEntry{"sun", 8},
+    TerminfoEntry{"sun1", 8},
+    TerminfoEntry{"sun2", 8},
+    TerminfoEntry{"teraterm", 8},
+    TerminfoEntry{"teraterm2.3", 8},
+    TerminfoEntry{"tmux", 8},
+    TerminfoEntry{"tmux-256color", 256},
+    TerminfoEntry{"vs100", 8},
+    TerminfoEntry{"vt100", 8},
+    TerminfoEntry{"vt100-am", 8},
+    TerminfoEntry{"vt100-nav", 8},
+    TerminfoEntry{"vt102", 8},
+    TerminfoEntry{"vt200", 8},
+    TerminfoEntry{"vt220", 8},
+    TerminfoEntry{"vt52", 8},
+    TerminfoEntry{"vte", 8},
+    TerminfoEntry{"vte-256color", 256},
+    TerminfoEntry{"vwmterm", 8},
+    TerminfoEntry{"wsvt25", 8},
+    TerminfoEntry{"wsvt25m", 8},
+    TerminfoEntry{"xfce", 8},
+    TerminfoEntry{"xterm", 8},
+    TerminfoEntry{"xterm-1002", 8},
+    TerminfoEntry{"xterm-1003", 8},
+    TerminfoEntry{"xterm-1005", 8},
+    TerminfoEntry{"xterm-1006", 8},
+    TerminfoEntry{"xterm-16color", 16},
+    TerminfoEntry{"xterm-24", 8},
+    TerminfoEntry{"xterm-256color", 256},
+    TerminfoEntry{"xterm-88color", 88},
+    TerminfoEntry{"xterm-8bit", 8},
+    TerminfoEntry{"xterm-basic", 8},
+    TerminfoEntry{"xterm-bold", 8},
+    TerminfoEntry{"xterm-color", 8},
+    TerminfoEntry{"xterm-direct", 256},
+    TerminfoEntry{"xterm-direct2", 256},
+    TerminfoEntry{"xterm-hp", 8},
+    TerminfoEntry{"xterm-kitty", 256},
+    TerminfoEntry{"xterm-mono", 8},
+    TerminfoEntry{"xterm-new", 8},
+    TerminfoEntry{"xterm-nic", 8},
+    TerminfoEntry{"xterm-noapp", 8},
+    TerminfoEntry{"xterm-old", 8},
+    TerminfoEntry{"xterm-pcolor", 8},
+    TerminfoEntry{"xterm-r5", 8},
+    TerminfoEntry{"xterm-r6", 8},
+    TerminfoEntry{"xterm-sco", 8},
+    TerminfoEntry{"xterm-sun", 8},
+    TerminfoEntry{"xterm-utf8", 8},
+    TerminfoEntry{"xterm-vt220", 8},
+    TerminfoEntry{"xterm-vt52", 8},
+    TerminfoEntry{"xterm-x10mouse", 8},
+    TerminfoEntry{"xterm-x11hilite", 8},
+    TerminfoEntry{"xterm-x11mouse", 8},
+    TerminfoEntry{"xterm-xf86-v32", 8},
+    TerminfoEntry{"xterm-xf86-v33", 8},
+    TerminfoEntry{"xterm-xf86-v333", 8},
+    TerminfoEntry{"xterm-xf86-v40", 8},
+    TerminfoEntry{"xterm-xf86-v43", 8},
+    TerminfoEntry{"xterm-xf86-v44", 8},
+    TerminfoEntry{"xterm-xfree86", 8},
+    TerminfoEntry{"xterm-xi", 8},
+    TerminfoEntry{"xterms", 8},
 };
 
+static_assert(std::ranges::is_sorted(terminfo_db, {}, &TerminfoEntry::TERM_name));
+
 /**
- * Find the terminfo for the given term_name using the terminfo_db object.
+ * Find the entry for \p term_name in terminfo_db, by binary search.
  * @param term_name The name of the terminal to find.
- * @return The terminfo for the given term_name.
- * @throws std::runtime_error if term_name is not found.
+ * @return The entry for \p term_name, or std::nullopt if it is not in terminfo_db.
  */
-[[nodiscard]] auto find_terminfo(std::string_view term_name) -> Terminfo
+[[nodiscard]] constexpr auto find_terminfo(std::string_view term_name)
+    -> std::optional<TerminfoEntry>
 {
-    auto const at = std::ranges::find_if(
-        terminfo_db, [term_name](auto ti) { return ti.TERM_name == term_name; });
-    if (at == std::cend(terminfo_db)) {
-        throw std::runtime_error{"find_terminfo(): term_name not found."};
+    auto const at =
+        std::ranges::lower_bound(terminfo_db, term_name, {}, &TerminfoEntry::TERM_name);
+    if (at == std::cend(terminfo_db) || at->TERM_name != term_name) {
+        return std::nullopt;
     }
     return *at;
 }
 
+static_assert(find_terminfo("xterm-256color")->color_palette_size == 256);
+static_assert(!find_terminfo("not-a-terminal").has_value());
+
 /**
  * Return the value of the given environment variable.
  * @param name The name of the environment variable to get.
@@ -199,22 +218,467 @@ auto const TERM = get_env("TERM");
 
 auto const COLORTERM = get_env("COLORTERM");
 
+// COMPILED TERMINFO -------------------------------------------------------------------
+
+constexpr auto legacy_magic = 0432;           // 16 bit numbers.
+constexpr auto extended_number_magic = 01036;  // 32 bit numbers.
+constexpr auto header_size = std::size_t{12};
+constexpr auto extended_header_size = std::size_t{10};
+
+// Capability names, in the order they are stored in the compiled file, from ncurses.
+constexpr auto flag_names = std::array<std::string_view, 44>{
+    "bw", "am", "xsb", "xhp", "xenl", "eo", "gn", "hc", "km", "hs", "in", "da", "db",
+    "mir", "msgr", "os", "eslok", "xt", "hz", "ul", "xon", "nxon", "mc5i", "chts",
+    "nrrmc", "npc", "ndscr", "ccc", "bce", "hls", "xhpa", "crxm", "daisy", "xvpa",
+    "sam", "cpix", "lpix", "OTbs", "OTns", "OTnc", "OTMT", "OTNL", "OTpt", "OTxr",
+};
+
+constexpr auto number_names = std::array<std::string_view, 39>{
+    "cols", "it", "lines", "lm", "xmc", "pb", "vt", "wsl", "nlab", "lh", "lw", "ma",
+    "wnum", "colors", "pairs", "ncv", "bufsz", "spinv", "spinh", "maddr", "mjump",
+    "mcs", "mls", "npins", "orc", "orl", "orhi", "orvi", "cps", "widcs", "btns",
+    "bitwin", "bitype", "OTug", "OTdC", "OTdN", "OTdB", "OTdT", "OTkn",
+};
+
+constexpr auto string_names = std::array<std::string_view, 414>{
+    "cbt", "bel", "cr", "csr", "tbc", "clear", "el", "ed", "hpa", "cmdch", "cup",
+    "cud1", "home", "civis", "cub1", "mrcup", "cnorm", "cuf1", "ll", "cuu1", "cvvis",
+    "dch1", "dl1", "dsl", "hd", "smacs", "blink", "bold", "smcup", "smdc", "dim",
+    "smir", "invis", "prot", "rev", "smso", "smul", "ech", "rmacs", "sgr0", "rmcup",
+    "rmdc", "rmir", "rmso", "rmul", "flash", "ff", "fsl", "is1", "is2", "is3", "if",
+    "ich1", "il1", "ip", "kbs", "ktbc", "kclr", "kctab", "kdch1", "kdl1", "kcud1",
+    "krmir", "kel", "ked", "kf0", "kf1", "kf10", "kf2", "kf3", "kf4", "kf5", "kf6",
+    "kf7", "kf8", "kf9", "khome", "kich1", "kil1", "kcub1", "kll", "knp", "kpp",
+    "kcuf1", "kind", "kri", "khts", "kcuu1", "rmkx", "smkx", "lf0", "lf1", "lf10",
+    "lf2", "lf3", "lf4", "lf5", "lf6", "lf7", "lf8", "lf9", "rmm", "smm", "nel", "pad",
+    "dch", "dl", "cud", "ich", "indn", "il", "cub", "cuf", "rin", "cuu", "pfkey",
+    "pfloc", "pfx", "mc0", "mc4", "mc5", "rep", "rs1", "rs2", "rs3", "rf", "rc", "vpa",
+    "sc", "ind", "ri", "sgr", "hts", "wind", "ht", "tsl", "uc", "hu", "iprog", "ka1",
+    "ka3", "kb2", "kc1", "kc3", "mc5p", "rmp", "acsc", "pln", "kcbt", "smxon", "rmxon",
+    "smam", "rmam", "xonc", "xoffc", "enacs", "smln", "rmln", "kbeg", "kcan", "kclo",
+    "kcmd", "kcpy", "kcrt", "kend", "kent", "kext", "kfnd", "khlp", "kmrk", "kmsg",
+    "kmov", "knxt", "kopn", "kopt", "kprv", "kprt", "krdo", "kref", "krfr", "krpl",
+    "krst", "kres", "ksav", "kspd", "kund", "kBEG", "kCAN", "kCMD", "kCPY", "kCRT",
+    "kDC", "kDL", "kslt", "kEND", "kEOL", "kEXT", "kFND", "kHLP", "kHOM", "kIC",
+    "kLFT", "kMSG", "kMOV", "kNXT", "kOPT", "kPRV", "kPRT", "kRDO", "kRPL", "kRIT",
+    "kRES", "kSAV", "kSPD", "kUND", "rfi", "kf11", "kf12", "kf13", "kf14", "kf15",
+    "kf16", "kf17", "kf18", "kf19", "kf20", "kf21", "kf22", "kf23", "kf24", "kf25",
+    "kf26", "kf27", "kf28", "kf29", "kf30", "kf31", "kf32", "kf33", "kf34", "kf35",
+    "kf36", "kf37", "kf38", "kf39", "kf40", "kf41", "kf42", "kf43", "kf44", "kf45",
+    "kf46", "kf47", "kf48", "kf49", "kf50", "kf51", "kf52", "kf53", "kf54", "kf55",
+    "kf56", "kf57", "kf58", "kf59", "kf60", "kf61", "kf62", "kf63", "el1", "mgc",
+    "smgl", "smgr", "fln", "sclk", "dclk", "rmclk", "cwin", "wingo", "hup", "dial",
+    "qdial", "tone", "pulse", "hook", "pause", "wait", "u0", "u1", "u2", "u3", "u4",
+    "u5", "u6", "u7", "u8", "u9", "op", "oc", "initc", "initp", "scp", "setf", "setb",
+    "cpi", "lpi", "chr", "cvr", "defc", "swidm", "sdrfq", "sitm", "slm", "smicm",
+    "snlq", "snrmq", "sshm", "ssubm", "ssupm", "sum", "rwidm", "ritm", "rlm", "rmicm",
+    "rshm", "rsubm", "rsupm", "rum", "mhpa", "mcud1", "mcub1", "mcuf1", "mvpa",
+    "mcuu1", "porder", "mcud", "mcub", "mcuf", "mcuu", "scs", "smgb", "smgbp", "smglp",
+    "smgrp", "smgt", "smgtp", "sbim", "scsd", "rbim", "rcsd", "subcs", "supcs", "docr",
+    "zerom", "csnm", "kmous", "minfo", "reqmp", "getm", "setaf", "setab", "pfxl",
+    "devt", "csin", "s0ds", "s1ds", "s2ds", "s3ds", "smglr", "smgtb", "birep", "binel",
+    "bicr", "colornm", "defbi", "endbi", "setcolor", "slines", "dispc", "smpch",
+    "rmpch", "smsc", "rmsc", "pctrm", "scesc", "scesa", "ehhlm", "elhlm", "elohlm",
+    "erhlm", "ethlm", "evhlm", "sgr1", "slength", "OTi2", "OTrs", "OTnl", "OTbc",
+    "OTko", "OTma", "OTG2", "OTG3", "OTG1", "OTG4", "OTGR", "OTGL", "OTGU", "OTGD",
+    "OTGH", "OTGV", "OTGC", "meml", "memu", "box1",
+};
+
+/**
+ * Read a little endian, signed 16 bit integer.
+ */
+[[nodiscard]] auto read_short(char const* p) -> int
+{
+    auto const lo = static_cast<unsigned char>(p[0]);
+    auto const hi = static_cast<unsigned char>(p[1]);
+    return static_cast<std::int16_t>(static_cast<std::uint16_t>(lo | (hi << 8)));
+}
+
+/**
+ * Read a little endian, signed 32 bit integer.
+ */
+[[nodiscard]] auto read_int(char const* p) -> int
+{
+    auto value = std::uint32_t{0};
+    for (auto i = 3; i >= 0; --i) {
+        value = (value << 8) | static_cast<unsigned char>(p[i]);
+    }
+    return static_cast<std::int32_t>(value);
+}
+
+/**
+ * Return the null terminated string at \p offset in a string table.
+ * @return The string, or std::nullopt if \p offset is absent, cancelled or out of
+ * range.
+ */
+[[nodiscard]] auto read_table(char const* table, std::size_t table_size, int offset)
+    -> std::optional<std::string_view>
+{
+    if (offset < 0 || static_cast<std::size_t>(offset) >= table_size) {
+        return std::nullopt;
+    }
+    auto const rest = std::string_view{table + offset, table_size - offset};
+    return rest.substr(0, rest.find('\0'));
+}
+
+/**
+ * Map each name in \p names to its index.
+ */
+[[nodiscard]] auto make_index(std::span<std::string_view const> names)
+    -> std::unordered_map<std::string_view, std::size_t>
+{
+    auto index = std::unordered_map<std::string_view, std::size_t>{};
+    index.reserve(names.size());
+    for (auto i = std::size_t{0}; i < names.size(); ++i) {
+        index.emplace(names[i], i);
+    }
+    return index;
+}
+
+/**
+ * Return the directories to search for compiled terminfo files, in order.
+ */
+[[nodiscard]] auto terminfo_dirs() -> std::vector<std::string>
+{
+    auto dirs = std::vector<std::string>{};
+    if (auto const terminfo = get_env("TERMINFO"); !terminfo.empty()) {
+        dirs.push_back(terminfo);
+    }
+    if (auto const home = get_env("HOME"); !home.empty()) {
+        dirs.push_back(home + "/.terminfo");
+    }
+    auto const list = get_env("TERMINFO_DIRS");
+    for (auto begin = std::size_t{0}; begin < list.size();) {
+        auto end = list.find(':', begin);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        auto dir = list.substr(begin, end - begin);
+        dirs.push_back(dir.empty() ? "/usr/share/terminfo" : std::move(dir));
+        begin = end + 1;
+    }
+    for (auto const* dir : {"/etc/terminfo", "/lib/terminfo", "/usr/share/terminfo"}) {
+        dirs.push_back(dir);
+    }
+    return dirs;
+}
+
+/**
+ * Search the terminfo directories for the compiled entry of \p term_name.
+ * @details Entries are in a subdirectory named by the first character of the name,
+ * or by its hex value on case insensitive file systems.
+ */
+[[nodiscard]] auto find_terminfo_file(std::string_view term_name)
+    -> std::optional<esc::Terminfo>
+{
+    if (term_name.empty() || term_name.find('/') != std::string_view::npos) {
+        return std::nullopt;
+    }
+    static auto const dirs = ::terminfo_dirs();
+
+    auto hex = std::array<char, 3>{};
+    std::snprintf(hex.data(), hex.size(), "%02x",
+                  static_cast<unsigned char>(term_name.front()));
+    auto const subdirs = std::array<std::string, 2>{
+        std::string(1, term_name.front()), std::string{hex.data()}};
+
+    for (auto const& dir : dirs) {
+        for (auto const& subdir : subdirs) {
+            auto const path = dir + '/' + subdir + '/' + std::string{term_name};
+            if (auto terminfo = esc::Terminfo::open(path); terminfo.has_value()) {
+                return terminfo;
+            }
+        }
+    }
+    return std::nullopt;
+}
+
 }  // namespace
 
 namespace esc {
 
+auto Terminfo::open(std::string const& path) -> std::optional<Terminfo>
+{
+    auto const fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::nullopt;
+    }
+    struct ::stat status = {};
+    auto const is_file =
+        ::fstat(fd, &status) == 0 && S_ISREG(status.st_mode) && status.st_size > 0;
+    auto const size = is_file ? static_cast<std::size_t>(status.st_size) : 0;
+    auto* const map =
+        is_file ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED) {
+        return std::nullopt;
+    }
+
+    auto result = Terminfo{static_cast<char const*>(map), size};
+    if (!result.parse()) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+Terminfo::Terminfo(Terminfo&& other) noexcept
+    : data_{std::exchange(other.data_, nullptr)},
+      size_{std::exchange(other.size_, 0)},
+      number_size_{other.number_size_},
+      names_{other.names_},
+      standard_{other.standard_},
+      extended_{other.extended_},
+      extended_names_{std::move(other.extended_names_)}
+{}
+
+auto Terminfo::operator=(Terminfo&& other) noexcept -> Terminfo&
+{
+    if (this != &other) {
+        if (data_ != nullptr) {
+            ::munmap(const_cast<char*>(data_), size_);
+        }
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        number_size_ = other.number_size_;
+        names_ = other.names_;
+        standard_ = other.standard_;
+        extended_ = other.extended_;
+        extended_names_ = std::move(other.extended_names_);
+    }
+    return *this;
+}
+
+Terminfo::~Terminfo()
+{
+    if (data_ != nullptr) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+}
+
+auto Terminfo::flag(std::string_view capname) const -> bool
+{
+    static auto const index = ::make_index(flag_names);
+    if (auto const at = index.find(capname); at != std::cend(index)) {
+        return this->read_flag(standard_, at->second);
+    }
+    if (auto const at = extended_names_.find(capname);
+        at != std::cend(extended_names_)) {
+        return this->read_flag(extended_, at->second);
+    }
+    return false;
+}
+
+auto Terminfo::number(std::string_view capname) const -> std::optional<int>
+{
+    static auto const index = ::make_index(number_names);
+    if (auto const at = index.find(capname); at != std::cend(index)) {
+        return this->read_number(standard_, at->second);
+    }
+    if (auto const at = extended_names_.find(capname);
+        at != std::cend(extended_names_) && at->second >= extended_.flag_count) {
+        return this->read_number(extended_, at->second - extended_.flag_count);
+    }
+    return std::nullopt;
+}
+
+auto Terminfo::string(std::string_view capname) const
+    -> std::optional<std::string_view>
+{
+    static auto const index = ::make_index(string_names);
+    if (auto const at = index.find(capname); at != std::cend(index)) {
+        return this->read_string(standard_, at->second);
+    }
+    auto const skip = extended_.flag_count + extended_.number_count;
+    if (auto const at = extended_names_.find(capname);
+        at != std::cend(extended_names_) && at->second >= skip) {
+        return this->read_string(extended_, at->second - skip);
+    }
+    return std::nullopt;
+}
+
+auto Terminfo::parse() -> bool
+{
+    auto at = header_size;
+
+    // Return the next n bytes, or nullptr if the file is too short.
+    auto const take = [this, &at](int n) -> char const* {
+        if (n < 0 || static_cast<std::size_t>(n) > size_ - at) {
+            return nullptr;
+        }
+        auto const* const p = data_ + at;
+        at += static_cast<std::size_t>(n);
+        return p;
+    };
+
+    // Numbers start on an even byte.
+    auto const align = [this, &at] {
+        if (at % 2 != 0 && at < size_) {
+            ++at;
+        }
+    };
+
+    if (size_ < header_size) {
+        return false;
+    }
+    auto const magic = ::read_short(data_);
+    if (magic == legacy_magic) {
+        number_size_ = 2;
+    }
+    else if (magic == extended_number_magic) {
+        number_size_ = 4;
+    }
+    else {
+        return false;
+    }
+    auto const names_size = ::read_short(data_ + 2);
+    auto const flag_count = ::read_short(data_ + 4);
+    auto const number_count = ::read_short(data_ + 6);
+    auto const string_count = ::read_short(data_ + 8);
+    auto const table_size = ::read_short(data_ + 10);
+    auto const number_size = static_cast<int>(number_size_);
+
+    auto const* const names = take(names_size);
+    auto const* const flags = take(flag_count);
+    align();
+    auto const* const numbers = take(number_count * number_size);
+    auto const* const offsets = take(string_count * 2);
+    auto const* const table = take(table_size);
+    if (names == nullptr || flags == nullptr || numbers == nullptr ||
+        offsets == nullptr || table == nullptr) {
+        return false;
+    }
+    names_ = std::string_view{names, static_cast<std::size_t>(names_size)};
+    names_ = names_.substr(0, names_.find('\0'));
+    standard_ = {flags,
+                 numbers,
+                 offsets,
+                 table,
+                 static_cast<std::size_t>(flag_count),
+                 static_cast<std::size_t>(number_count),
+                 static_cast<std::size_t>(string_count),
+                 static_cast<std::size_t>(table_size)};
+
+    // The extended section is optional, a malformed one is ignored.
+    align();
+    auto const* const header = take(static_cast<int>(extended_header_size));
+    if (header == nullptr) {
+        return true;
+    }
+    auto const ext_flag_count = ::read_short(header);
+    auto const ext_number_count = ::read_short(header + 2);
+    auto const ext_string_count = ::read_short(header + 4);
+    auto const ext_table_size = ::read_short(header + 8);
+    auto const name_count = ext_flag_count + ext_number_count + ext_string_count;
+
+    auto const* const ext_flags = take(ext_flag_count);
+    align();
+    auto const* const ext_numbers = take(ext_number_count * number_size);
+    auto const* const ext_offsets = take(ext_string_count * 2);
+    auto const* const name_offsets = take(name_count * 2);
+    auto const* const ext_table = take(ext_table_size);
+    if (ext_flags == nullptr || ext_numbers == nullptr || ext_offsets == nullptr ||
+        name_offsets == nullptr || ext_table == nullptr) {
+        return true;
+    }
+    extended_ = {ext_flags,
+                 ext_numbers,
+                 ext_offsets,
+                 ext_table,
+                 static_cast<std::size_t>(ext_flag_count),
+                 static_cast<std::size_t>(ext_number_count),
+                 static_cast<std::size_t>(ext_string_count),
+                 static_cast<std::size_t>(ext_table_size)};
+
+    // The names follow the string values in the table.
+    auto names_begin = std::size_t{0};
+    for (auto i = std::size_t{0}; i < extended_.string_count; ++i) {
+        auto const offset = ::read_short(ext_offsets + 2 * i);
+        if (auto const value = ::read_table(ext_table, extended_.table_size, offset)) {
+            auto const end = static_cast<std::size_t>(offset) + value->size() + 1;
+            names_begin = std::max(names_begin, end);
+        }
+    }
+    names_begin = std::min(names_begin, extended_.table_size);
+    auto const* const names_table = ext_table + names_begin;
+    auto const names_table_size = extended_.table_size - names_begin;
+    for (auto i = 0; i < name_count; ++i) {
+        auto const offset = ::read_short(name_offsets + 2 * i);
+        if (auto const name = ::read_table(names_table, names_table_size, offset)) {
+            extended_names_.emplace(*name, static_cast<std::size_t>(i));
+        }
+    }
+    return true;
+}
+
+auto Terminfo::read_flag(Section const& section, std::size_t index) const -> bool
+{
+    return index < section.flag_count && section.flags[index] == 1;
+}
+
+auto Terminfo::read_number(Section const& section, std::size_t index) const
+    -> std::optional<int>
+{
+    if (index >= section.number_count) {
+        return std::nullopt;
+    }
+    auto const* const p = section.numbers + index * number_size_;
+    auto const value = number_size_ == 2 ? ::read_short(p) : ::read_int(p);
+    if (value < 0) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+auto Terminfo::read_string(Section const& section, std::size_t index) const
+    -> std::optional<std::string_view>
+{
+    if (index >= section.string_count) {
+        return std::nullopt;
+    }
+    return ::read_table(section.table, section.table_size,
+                        ::read_short(section.offsets + 2 * index));
+}
+
 auto TERM_var() -> std::string_view { return TERM; }
 
+auto load_terminfo(std::string_view term_name) -> Terminfo const*
+{
+    static auto mtx = std::mutex{};
+    static auto cache = std::unordered_map<std::string, std::optional<Terminfo>>{};
+
+    auto const lock = std::scoped_lock{mtx};
+    auto key = std::string{term_name};
+    auto at = cache.find(key);
+    if (at == std::end(cache)) {
+        at = cache.emplace(std::move(key), ::find_terminfo_file(term_name)).first;
+    }
+    return at->second.has_value() ? &*at->second : nullptr;
+}
+
 auto color_palette_size() -> std::uint16_t
 {
-    static auto const terminfo = find_terminfo(TERM);
-    return terminfo.color_palette_size;
+    static auto const size = [] {
+        if (auto const* const terminfo = load_terminfo(TERM); terminfo != nullptr) {
+            auto const colors = terminfo->number("colors").value_or(8);
+            return static_cast<std::uint16_t>(std::min(colors, 256));
+        }
+        auto const entry = find_terminfo(TERM);
+        return entry.has_value() ? entry->color_palette_size : std::uint16_t{8};
+    }();
+    return size;
 }
 
 auto has_true_color() -> bool
 {
-    return COLORTERM == "truecolor" || COLORTERM == "24bit" ||
-           TERM == "xterm-256color" || TERM == "st-256color";
+    if (COLORTERM == "truecolor" || COLORTERM == "24bit" ||
+        capabilities().true_color) {
+        return true;
+    }
+    if (auto const* const terminfo = load_terminfo(TERM); terminfo != nullptr &&
+        (terminfo->flag("RGB") || terminfo->flag("Tc"))) {
+        return true;
+    }
+    return TERM == "xterm-256color" || TERM == "st-256color";
 }
 
 }  // namespace esc
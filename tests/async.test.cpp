@@ -0,0 +1,86 @@
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+#include <zzz/test.hpp>
+
+#include <esc/async.hpp>
+
+using namespace esc;
+using namespace std::chrono_literals;
+
+namespace {
+
+auto append_after(std::chrono::milliseconds delay, char c, std::string& out) -> Task
+{
+    co_await sleep_for(delay);
+    out.push_back(c);
+}
+
+auto ticker(int count, char c, std::string& out) -> Task
+{
+    for (auto i = 0; i < count; ++i) {
+        out.push_back(c);
+        co_await sleep_for(1ms);
+    }
+}
+
+auto throw_after_sleep() -> Task
+{
+    co_await sleep_for(0ms);
+    throw std::runtime_error{"from task"};
+}
+
+}  // namespace
+
+TEST(scheduler_timers_in_order)
+{
+    auto out = std::string{};
+    auto scheduler = Scheduler{};
+    scheduler.spawn(append_after(20ms, 'c', out));
+    scheduler.spawn(append_after(0ms, 'a', out));
+    scheduler.spawn(append_after(10ms, 'b', out));
+
+    auto const start = Scheduler::Clock::now();
+    scheduler.run();
+    ASSERT(out == "abc");
+    ASSERT(Scheduler::Clock::now() - start >= 20ms);
+}
+
+TEST(scheduler_interleaves_tasks)
+{
+    auto out = std::string{};
+    auto scheduler = Scheduler{};
+    scheduler.spawn(ticker(3, 'x', out));
+    scheduler.spawn(ticker(3, 'y', out));
+    scheduler.run();
+    ASSERT(out.size() == 6);
+    ASSERT(out.substr(0, 2) == "xy");
+}
+
+TEST(scheduler_rethrows_task_exception)
+{
+    auto scheduler = Scheduler{};
+    scheduler.spawn(throw_after_sleep());
+    auto caught = false;
+    try {
+        scheduler.run();
+    }
+    catch (std::runtime_error const& e) {
+        caught = std::string{e.what()} == "from task";
+    }
+    ASSERT(caught);
+}
+
+TEST(scheduler_destroys_unfinished_tasks)
+{
+    auto out = std::string{};
+    {
+        auto scheduler = Scheduler{};
+        scheduler.spawn(append_after(1h, 'z', out));
+    }
+    {
+        auto task = append_after(0ms, 'z', out);
+    }
+    ASSERT(out.empty());
+}
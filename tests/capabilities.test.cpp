@@ -0,0 +1,120 @@
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
+
+#include <zzz/test.hpp>
+
+#include <esc/capabilities.hpp>
+#include <esc/detail/capability_cache.hpp>
+#include <esc/detail/query.hpp>
+#include <esc/event.hpp>
+#include <esc/input_parser.hpp>
+#include <esc/key.hpp>
+
+using namespace esc;
+
+TEST(capabilities_parse_replies)
+{
+    auto const replies = std::string_view{
+        "\033[>41;390;0c"
+        "\033P>|XTerm(390)\033\\"
+        "\033[?2026;2$y"
+        "\033[?2004;2$y"
+        "\033[?1006;1$y"
+        "\033[?1016;0$y"
+        "\033P1+r524742\033\\"
+        "\033P0+r5463\033\\"
+        "\033P1+r636f6c6f7273=323536\033\\"
+        "\033[?64;1;2;22c"};
+    auto const caps = detail::parse_probe_replies(replies);
+
+    ASSERT(caps.replied);
+    ASSERT(caps.device_attributes == (std::vector<int>{64, 1, 2, 22}));
+    ASSERT(caps.terminal_id == 41);
+    ASSERT(caps.firmware_version == 390);
+    ASSERT(caps.version == "XTerm(390)");
+    ASSERT(caps.synchronized_output);
+    ASSERT(caps.bracketed_paste);
+    ASSERT(caps.sgr_mouse);
+    ASSERT(!caps.sgr_pixel_mouse);
+    ASSERT(caps.true_color);
+    ASSERT(caps.colors == 256);
+}
+
+TEST(capabilities_minimal_terminal)
+{
+    // Only DA1, with keyboard input mixed in.
+    auto const caps = detail::parse_probe_replies("ab\033[?1;2c\033[A");
+    ASSERT(caps.replied);
+    ASSERT(caps.device_attributes == (std::vector<int>{1, 2}));
+    ASSERT(!caps.terminal_id.has_value());
+    ASSERT(caps.version.empty());
+    ASSERT(!caps.synchronized_output);
+    ASSERT(!caps.true_color);
+    ASSERT(!caps.colors.has_value());
+
+    ASSERT(!detail::parse_probe_replies("").replied);
+
+    // Permanently reset is not supported.
+    ASSERT(!detail::parse_probe_replies("\033[?2026;4$y").synchronized_output);
+}
+
+TEST(capabilities_cache_round_trip)
+{
+    auto const dir = std::filesystem::temp_directory_path() / "escape.cache.test";
+    auto const path = (dir / "record").string();
+    std::filesystem::remove_all(dir);
+    ASSERT(!detail::load_capabilities(path).has_value());
+
+    auto caps = Capabilities{};
+    caps.replied = true;
+    caps.device_attributes = {64, 1, 22};
+    caps.terminal_id = 41;
+    caps.version = "XTerm(390)";
+    caps.sgr_mouse = true;
+    caps.colors = 256;
+    detail::store_capabilities(path, caps);
+    ASSERT(detail::load_capabilities(path) == caps);
+
+    // A probe that timed out.
+    detail::store_capabilities(path, Capabilities{});
+    ASSERT(detail::load_capabilities(path) == Capabilities{});
+
+    std::filesystem::resize_file(path, 4);
+    ASSERT(!detail::load_capabilities(path).has_value());
+    std::filesystem::remove_all(dir);
+}
+
+TEST(capabilities_revalidate_from_input)
+{
+    auto const dir = std::filesystem::temp_directory_path() / "escape.cache.test";
+    auto const path = (dir / "record").string();
+    std::filesystem::remove_all(dir);
+
+    detail::probed_capabilities = Capabilities{};
+    detail::expect_probe_replies(path);
+
+    // Replies mixed with key presses, only the keys are Events.
+    auto const input = std::string_view{
+        "a\033[?2026;2$y\033P\033\\\033P>|foot(1.16)\033\\b\033[?62;4c\033[?1;2c"};
+    auto parser = InputParser{};
+    parser.feed(std::span<char const>{input.data(), input.size()});
+    auto keys = std::string{};
+    while (auto const event = parser.next_event()) {
+        ASSERT(std::holds_alternative<KeyPress>(*event));
+        keys.push_back(static_cast<char>(std::get<KeyPress>(*event).key));
+    }
+    ASSERT(keys == "ab");
+
+    ASSERT(capabilities().synchronized_output);
+    ASSERT(capabilities().version == "foot(1.16)");
+    ASSERT(capabilities().device_attributes == (std::vector<int>{62, 4}));
+    ASSERT(detail::load_capabilities(path) == capabilities());
+
+    detail::probed_capabilities = Capabilities{};
+    std::filesystem::remove_all(dir);
+}
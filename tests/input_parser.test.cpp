@@ -0,0 +1,236 @@
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <variant>
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include <zzz/test.hpp>
+
+#include <esc/area.hpp>
+#include <esc/detail/signals.hpp>
+#include <esc/event.hpp>
+#include <esc/input_parser.hpp>
+#include <esc/key.hpp>
+#include <esc/mouse.hpp>
+
+using namespace esc;
+
+namespace {
+
+void feed(InputParser& parser, std::string_view bytes)
+{
+    parser.feed(std::span<char const>{bytes.data(), bytes.size()});
+}
+
+[[nodiscard]] auto next_key(InputParser& parser) -> std::optional<Key>
+{
+    auto const event = parser.next_event();
+    if (!event.has_value() || !std::holds_alternative<KeyPress>(*event)) {
+        return std::nullopt;
+    }
+    return std::get<KeyPress>(*event).key;
+}
+
+}  // namespace
+
+TEST(input_parser_keys)
+{
+    auto parser = InputParser{};
+    feed(parser, "a\033[1;5C\033OP");
+    ASSERT(next_key(parser) == Key::a);
+    ASSERT(next_key(parser) == (Key::ArrowRight | Mod::Ctrl));
+    ASSERT(next_key(parser) == Key::Function1);
+    ASSERT(!parser.next_event().has_value());
+}
+
+TEST(input_parser_split_feeds)
+{
+    auto parser = InputParser{};
+    feed(parser, "\033[<0;5;");
+    ASSERT(!parser.next_event().has_value());
+    feed(parser, "6M\033[<0;5;6m");
+
+    auto const press = parser.next_event();
+    ASSERT(press.has_value() && std::holds_alternative<MousePress>(*press));
+    auto const mouse = std::get<MousePress>(*press).mouse;
+    ASSERT(mouse.at.x == 4 && mouse.at.y == 5);
+    ASSERT(mouse.button == Mouse::Button::Left);
+
+    auto const release = parser.next_event();
+    ASSERT(release.has_value() && std::holds_alternative<MouseRelease>(*release));
+}
+
+TEST(input_parser_flush)
+{
+    auto parser = InputParser{};
+    feed(parser, "\033");
+    ASSERT(!parser.next_event().has_value());
+    parser.flush();
+    ASSERT(next_key(parser) == Key::Escape);
+
+    // Alt + [
+    feed(parser, "\033[");
+    parser.flush();
+    ASSERT(next_key(parser) == Key::LeftBracket);
+
+    // A partial sequence waits for the rest.
+    feed(parser, "\033[1;");
+    parser.flush();
+    ASSERT(!parser.next_event().has_value());
+    feed(parser, "2A");
+    ASSERT(next_key(parser) == (Key::ArrowUp | Mod::Shift));
+}
+
+TEST(input_parser_strings_are_not_events)
+{
+    auto parser = InputParser{};
+    feed(parser, "\033]11;rgb:0/0/0\007\033P>|term\033\\x");
+    ASSERT(next_key(parser) == Key::x);
+    ASSERT(!parser.next_event().has_value());
+}
+
+TEST(input_parser_unknown_sequences)
+{
+    auto parser = InputParser{};
+    feed(parser, "\033[5ua\033[1;99Ab");
+    ASSERT(next_key(parser) == Key::a);
+    ASSERT(next_key(parser) == Key::b);
+    ASSERT(!parser.next_event().has_value());
+}
+
+TEST(input_parser_split_scancodes)
+{
+    auto parser = InputParser{};
+    auto const bytes = std::string_view{"\xE0\x48\xE0\xC8"};
+    parser.feed_scancodes(std::span<char const>{bytes.data(), 1});
+    ASSERT(!parser.next_event().has_value());
+    parser.feed_scancodes(std::span<char const>{bytes.data() + 1, 3});
+
+    auto const press = parser.next_event();
+    ASSERT(press.has_value() && std::holds_alternative<KeyPress>(*press));
+    ASSERT(std::get<KeyPress>(*press).key == Key::ArrowUp);
+
+    auto const release = parser.next_event();
+    ASSERT(release.has_value() && std::holds_alternative<KeyRelease>(*release));
+    ASSERT(std::get<KeyRelease>(*release).key == Key::ArrowUp);
+}
+
+TEST(input_parser_coalesce_mouse)
+{
+    auto const moves = std::string_view{"\033[<35;1;1M\033[<35;2;1M\033[<35;3;2M"};
+    auto const wheels = std::string_view{"\033[<64;4;4M\033[<64;5;4M\033[<65;5;4M"};
+
+    // Off by default.
+    auto parser = InputParser{};
+    feed(parser, moves);
+    auto count = 0;
+    while (parser.next_event().has_value()) {
+        ++count;
+    }
+    ASSERT(count == 3);
+
+    parser.set_coalescing(true);
+    feed(parser, moves);
+    feed(parser, "\033[<43;4;2M");  // Alt changes the modifiers.
+    feed(parser, wheels);
+
+    auto const move = parser.next_event();
+    ASSERT(move.has_value() && std::holds_alternative<MouseMove>(*move));
+    ASSERT(std::get<MouseMove>(*move).mouse.at.x == 2);
+    ASSERT(std::get<MouseMove>(*move).mouse.at.y == 1);
+
+    auto const alt_move = parser.next_event();
+    ASSERT(alt_move.has_value() && std::holds_alternative<MouseMove>(*alt_move));
+    ASSERT(std::get<MouseMove>(*alt_move).mouse.modifiers.alt);
+
+    auto const up = parser.next_event();
+    ASSERT(up.has_value() && std::holds_alternative<MouseWheel>(*up));
+    ASSERT(std::get<MouseWheel>(*up).count == 2);
+    ASSERT(std::get<MouseWheel>(*up).mouse.at.x == 4);
+
+    auto const down = parser.next_event();
+    ASSERT(down.has_value() && std::holds_alternative<MouseWheel>(*down));
+    ASSERT(std::get<MouseWheel>(*down).count == 1);
+    ASSERT(std::get<MouseWheel>(*down).mouse.button == Mouse::Button::ScrollDown);
+
+    ASSERT(!parser.next_event().has_value());
+}
+
+TEST(input_parser_event_timing)
+{
+    using namespace std::chrono_literals;
+    auto const t0 = InputParser::Clock::now();
+    auto const t1 = t0 + 5ms;
+
+    auto parser = InputParser{};
+    auto const first = std::string_view{"a\033[1;"};
+    auto const second = std::string_view{"5Cb"};
+    parser.feed(std::span<char const>{first.data(), first.size()}, t0);
+    parser.feed(std::span<char const>{second.data(), second.size()}, t1);
+
+    // A split sequence keeps the time its first byte was read.
+    ASSERT(next_key(parser) == Key::a);
+    ASSERT(parser.last_event_timing().read == t0);
+    ASSERT(next_key(parser) == (Key::ArrowRight | Mod::Ctrl));
+    ASSERT(parser.last_event_timing().read == t0);
+    ASSERT(parser.last_event_timing().parsed >= t0);
+    ASSERT(next_key(parser) == Key::b);
+    ASSERT(parser.last_event_timing().read == t1);
+}
+
+TEST(input_parser_resize_debounce)
+{
+    using namespace std::chrono_literals;
+
+    // The Resize size is read from stdout, make it a pseudo terminal for the test.
+    auto const master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    ASSERT(master >= 0 && ::grantpt(master) == 0 && ::unlockpt(master) == 0);
+    auto const slave = ::open(::ptsname(master), O_RDWR | O_NOCTTY);
+    ASSERT(slave >= 0);
+    auto const set_size = [slave](unsigned short width, unsigned short height) {
+        auto size = ::winsize{};
+        size.ws_col = width;
+        size.ws_row = height;
+        ::ioctl(slave, TIOCSWINSZ, &size);
+    };
+    std::fflush(stdout);
+    auto const saved_stdout = ::dup(STDOUT_FILENO);
+    ::dup2(slave, STDOUT_FILENO);
+
+    esc::detail::register_signals(false);
+    auto parser = InputParser{};
+    parser.set_resize_debounce(50ms);
+
+    // A drag resize, two signals within the delay.
+    set_size(80, 24);
+    std::raise(SIGWINCH);
+    auto const early = parser.next_event();
+    set_size(100, 30);
+    std::raise(SIGWINCH);
+    auto const held = parser.next_event();
+    auto const timeout = parser.resize_timeout();
+
+    std::this_thread::sleep_for(60ms);
+    auto const resize = parser.next_event();
+    auto const after = parser.next_event();
+
+    ::dup2(saved_stdout, STDOUT_FILENO);
+    ::close(saved_stdout);
+    ::close(slave);
+    ::close(master);
+
+    ASSERT(!early.has_value() && !held.has_value());
+    ASSERT(timeout > 0 && timeout <= 50);
+    ASSERT(resize.has_value() && std::holds_alternative<Resize>(*resize));
+    ASSERT(std::get<Resize>(*resize).size == (Area{.width = 100, .height = 30}));
+    ASSERT(!after.has_value());
+    ASSERT(parser.resize_timeout() == -1);
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdio>
+#include <span>
+#include <string_view>
+#include <variant>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <zzz/test.hpp>
+
+#include <esc/detail/query.hpp>
+#include <esc/event.hpp>
+#include <esc/io.hpp>
+#include <esc/key.hpp>
+
+using namespace esc;
+
+TEST(io_latency_hook)
+{
+    using Clock = std::chrono::steady_clock;
+    auto calls = 0;
+    auto latency = Clock::duration{-1};
+    set_latency_hook([&](EventTiming const& input, Clock::time_point flushed) {
+        ++calls;
+        latency = flushed - input.read;
+    });
+
+    auto const input = std::string_view{"a"};
+    detail::feed_input(std::span<char const>{input.data(), input.size()});
+    auto const event = read(0);
+    ASSERT(event.has_value() && std::holds_alternative<KeyPress>(*event));
+    ASSERT(std::get<KeyPress>(*event).key == Key::a);
+
+    // Flush to /dev/null so the test output is left alone.
+    std::fflush(stdout);
+    auto const saved_stdout = ::dup(STDOUT_FILENO);
+    auto const null = ::open("/dev/null", O_WRONLY);
+    ::dup2(null, STDOUT_FILENO);
+    write("x");
+    flush();
+    auto const calls_after_first = calls;
+    write("y");
+    flush();  // No new input, nothing to report.
+    ::dup2(saved_stdout, STDOUT_FILENO);
+    ::close(saved_stdout);
+    ::close(null);
+    set_latency_hook({});
+
+    ASSERT(calls_after_first == 1);
+    ASSERT(calls == 1);
+    ASSERT(latency >= Clock::duration::zero());
+}
@@ -0,0 +1,105 @@
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <zzz/test.hpp>
+
+#include <esc/detail/lexer.hpp>
+
+using namespace esc::detail;
+
+namespace {
+
+/**
+ * A Token with its bytes copied out of the Lexer.
+ */
+struct Lexed {
+    TokenKind kind;
+    std::string bytes;
+
+    auto operator==(Lexed const&) const -> bool = default;
+};
+
+/**
+ * Lex each chunk in turn, calling idle() after every chunk.
+ */
+[[nodiscard]] auto lex(std::vector<std::string_view> const& chunks,
+                       bool call_idle = true) -> std::vector<Lexed>
+{
+    auto lexer = Lexer{};
+    auto result = std::vector<Lexed>{};
+    for (auto chunk : chunks) {
+        auto input = std::span<char const>{chunk.data(), chunk.size()};
+        while (auto const token = lexer.next(input)) {
+            result.push_back({token->kind, std::string{token->bytes}});
+        }
+        if (call_idle) {
+            if (auto const token = lexer.idle()) {
+                result.push_back({token->kind, std::string{token->bytes}});
+            }
+        }
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST(lexer_text_and_control_sequences)
+{
+    auto const tokens = lex({"a\033[1;5C\033OP\033x\n"});
+    ASSERT(tokens == (std::vector<Lexed>{{TokenKind::Text, "a"},
+                                         {TokenKind::CSI, "1;5C"},
+                                         {TokenKind::SS3, "P"},
+                                         {TokenKind::Escaped, "x"},
+                                         {TokenKind::Text, "\n"}}));
+}
+
+TEST(lexer_split_anywhere)
+{
+    auto const input = std::string_view{"\033[<0;12;5M\033]11;rgb:0/0/0\007é\033[A"};
+    auto const whole = lex({input});
+    for (auto i = std::size_t{1}; i < input.size(); ++i) {
+        ASSERT(lex({input.substr(0, i), input.substr(i)}, false) == whole);
+    }
+    ASSERT(whole.size() == 4);
+    ASSERT(whole[2] == (Lexed{TokenKind::Text, "é"}));
+}
+
+TEST(lexer_strings)
+{
+    auto const tokens =
+        lex({"\033]0;title\033\\\033P>|xterm(390)\033\\\033_Gi=1\033\\\033Xsos\033\\"});
+    ASSERT(tokens == (std::vector<Lexed>{{TokenKind::OSC, "0;title"},
+                                         {TokenKind::DCS, ">|xterm(390)"},
+                                         {TokenKind::APC, "Gi=1"}}));
+
+    // ESC inside a string that does not start ST aborts the string.
+    ASSERT(lex({"\033]abc\033[B"}) == (std::vector<Lexed>{{TokenKind::CSI, "B"}}));
+}
+
+TEST(lexer_cancel)
+{
+    ASSERT(lex({"\033[12\030x"}) == (std::vector<Lexed>{{TokenKind::Text, "x"}}));
+    ASSERT(lex({"\033]abc\032y"}) == (std::vector<Lexed>{{TokenKind::Text, "y"}}));
+}
+
+TEST(lexer_idle)
+{
+    // Lone ESC, Alt + [ and Alt + P.
+    ASSERT(lex({"\033"}) == (std::vector<Lexed>{{TokenKind::Text, "\033"}}));
+    ASSERT(lex({"\033["}) == (std::vector<Lexed>{{TokenKind::Escaped, "["}}));
+    ASSERT(lex({"\033P"}) == (std::vector<Lexed>{{TokenKind::Escaped, "P"}}));
+
+    // Partial sequences keep waiting.
+    ASSERT(lex({"\033[1;", "5A"}) == (std::vector<Lexed>{{TokenKind::CSI, "1;5A"}}));
+    ASSERT(lex({"\xE2\x82", "\xAC"}) == (std::vector<Lexed>{{TokenKind::Text,
+                                                               "\xE2\x82\xAC"}}));
+}
+
+TEST(lexer_truncated_utf8)
+{
+    ASSERT(lex({"\xE2\x82x"}) == (std::vector<Lexed>{{TokenKind::Text, "\xE2\x82"},
+                                                     {TokenKind::Text, "x"}}));
+}
@@ -0,0 +1,74 @@
+#include <string>
+
+#include <zzz/test.hpp>
+
+#include <esc/brush.hpp>
+#include <esc/color.hpp>
+#include <esc/glyph.hpp>
+#include <esc/screen.hpp>
+#include <esc/sequence.hpp>
+
+using namespace esc;
+
+TEST(screen_first_render_repaints)
+{
+    auto screen = Screen{{.width = 3, .height = 2}};
+    ASSERT(screen.size() == Area{.width = 3, .height = 2});
+
+    screen[{.x = 1, .y = 1}] = Glyph{U'x'};
+
+    ASSERT(screen.render() == "\033[0m\033[2J\033[2;2Hx");
+}
+
+TEST(screen_render_only_changed_cells)
+{
+    auto screen = Screen{{.width = 4, .height = 2}};
+    screen.fill(Glyph{U'a'});
+    (void)screen.render();
+
+    // Nothing changed.
+    ASSERT(screen.render().empty());
+
+    // Adjacent cells share one cursor move and one brush change, the last cell
+    // written was in the last column so the first move is absolute.
+    auto const red = Brush{.foreground = XColor::Red};
+    screen[{.x = 1, .y = 0}] = U'b' | red;
+    screen[{.x = 2, .y = 0}] = U'c' | red;
+    screen[{.x = 0, .y = 1}] = Glyph{U'd'};
+
+    ASSERT(screen.render() == "\033[;2H\033[31mbc\r\n\033[0md");
+}
+
+TEST(screen_invalidate_and_resize)
+{
+    auto screen = Screen{{.width = 2, .height = 1}};
+    screen[{.x = 0, .y = 0}] = Glyph{U'é'};
+    (void)screen.render();
+
+    screen.invalidate();
+    ASSERT(screen.render() == "\033[0m\033[2J\033[Hé");
+
+    screen.resize({.width = 1, .height = 1});
+    ASSERT(screen.size() == Area{.width = 1, .height = 1});
+    ASSERT(screen[{.x = 0, .y = 0}] == Glyph{});
+    ASSERT(screen.render() == "\033[0m\033[2J");
+}
+
+TEST(screen_cheapest_cursor_moves)
+{
+    auto screen = Screen{{.width = 30, .height = 4}};
+    screen.fill(Glyph{U'a'});
+    screen[{.x = 29, .y = 3}] = Glyph{U'z'};
+    (void)screen.render();
+
+    // Rewriting two unchanged cells is cheaper than moving over them.
+    screen[{.x = 0, .y = 0}] = Glyph{U'x'};
+    screen[{.x = 3, .y = 0}] = Glyph{U'y'};
+    // Relative move right.
+    screen[{.x = 20, .y = 0}] = Glyph{U'w'};
+    // Relative move down.
+    screen[{.x = 21, .y = 2}] = Glyph{U'v'};
+    // Relative move down and backspaces.
+    screen[{.x = 20, .y = 3}] = Glyph{U'u'};
+    ASSERT(screen.render() == "\033[Hxaay\033[16Cw\033[2Bv\033[B\b\bu");
+}
@@ -0,0 +1,167 @@
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include <zzz/test.hpp>
+
+#include <esc/brush.hpp>
+#include <esc/color.hpp>
+#include <esc/sequence.hpp>
+#include <esc/trait.hpp>
+
+using namespace esc;
+
+TEST(escape_sequences)
+{
+    ASSERT(escape(Cursor{.x = 4, .y = 9}) == "\033[10;5H");
+    ASSERT(escape(BlankRow{}) == "\033[2K");
+    ASSERT(escape(BlankScreen{}) == "\033[2J");
+    ASSERT(escape(Trait::None) == "\033[22;23;24;25;27;28;29m");
+    ASSERT(escape(Trait::Bold | Trait::Underline) == "\033[22;23;24;25;27;28;29;1;4m");
+    ASSERT(escape(Trait::Standout) == "\033[22;23;24;25;27;28;29;1;7m");
+    ASSERT(escape(bg(XColor{200})) == "\033[48;5;200m");
+    ASSERT(escape(fg(TColor{0x0A0B0C})) == "\033[38;2;10;11;12m");
+    ASSERT(escape(fg(TermColor::Default)) == "\033[39m");
+}
+
+TEST(escape_to_appends)
+{
+    auto out = std::string{"x"};
+    escape_to(out, Cursor{.x = 0, .y = 0});
+    ASSERT(out == "x\033[1;1H");
+
+    out.clear();
+    auto const brush = Brush{
+        .background = TColor{0xFF0000},
+        .foreground = XColor::Blue,
+        .traits = Trait::Italic,
+    };
+    escape_to(out, brush);
+    ASSERT(out == escape(brush));
+
+    out.clear();
+    escape_to(out, Cursor{.x = 1, .y = 2}, fg(XColor::Red), Trait::Dim);
+    ASSERT(out == escape(Cursor{.x = 1, .y = 2}, fg(XColor::Red), Trait::Dim));
+    ASSERT(out == escape(Cursor{.x = 1, .y = 2}) + escape(fg(XColor::Red)) +
+                      escape(Trait::Dim));
+}
+
+TEST(brush_tracker_delta)
+{
+    auto tracker = BrushTracker{};
+    ASSERT(!tracker.brush().has_value());
+
+    // Unknown state is reset first.
+    ASSERT(tracker.escape(Brush{.traits = Trait::Bold}) == "\033[0;1m");
+    ASSERT(tracker.brush() == Brush{.traits = Trait::Bold});
+
+    // Same Brush is a no-op.
+    ASSERT(tracker.escape(Brush{.traits = Trait::Bold}).empty());
+
+    // Only the foreground changed.
+    ASSERT(tracker.escape({.foreground = XColor{100}, .traits = Trait::Bold}) ==
+           "\033[38;5;100m");
+
+    // Colors and Traits are merged into one sequence.
+    ASSERT(tracker.escape({
+               .background = TColor{0x010203},
+               .foreground = XColor::BrightRed,
+               .traits = Trait::Bold | Trait::Italic,
+           }) == "\033[3;48;2;1;2;3;91m");
+
+    // Removing Dim resets Bold as well, Bold is set again.
+    tracker.invalidate();
+    (void)tracker.escape({.traits = Trait::Bold | Trait::Dim | Trait::Underline});
+    ASSERT(tracker.escape({.traits = Trait::Bold | Trait::Underline}) ==
+           "\033[22;1m");
+
+    // Standout is Bold + Inverse.
+    ASSERT(tracker.escape({.traits = Trait::Standout | Trait::Underline}) ==
+           "\033[7m");
+    ASSERT(tracker.escape({.traits = Trait::Bold | Trait::Inverse |
+                                     Trait::Underline})
+               .empty());
+
+    // Full reset is shorter than removing every Trait.
+    ASSERT(tracker.escape(Brush{}) == "\033[0m");
+}
+
+TEST(cursor_tracker)
+{
+    auto cursor = CursorTracker{};
+    ASSERT(cursor.escape({.x = 4, .y = 9}) == "\033[10;5H");
+    ASSERT(cursor.escape({.x = 4, .y = 9}).empty());
+    ASSERT(cursor.escape({.x = 0, .y = 9}) == "\r");
+    ASSERT(cursor.escape({.x = 0, .y = 11}) == "\r\n\n");
+    ASSERT(cursor.escape({.x = 5, .y = 11}) == "\033[5C");
+    ASSERT(cursor.escape({.x = 3, .y = 11}) == "\b\b");
+    ASSERT(cursor.escape({.x = 3, .y = 10}) == "\033[A");
+    ASSERT(cursor.escape({.x = 3, .y = 100}) == "\033[90B");
+    ASSERT(cursor.escape({.x = 3, .y = 5}) == "\033[6d");
+    ASSERT(cursor.escape({.x = 99, .y = 5}) == "\033[96C");
+    ASSERT(cursor.escape({.x = 7, .y = 5}) == "\033[8G");
+    ASSERT(cursor.escape({.x = 1, .y = 0}) == "\033[;2H");
+    cursor.advance(3);
+    ASSERT(cursor.cursor() == Cursor{.x = 4, .y = 0});
+    cursor.invalidate();
+    ASSERT(cursor.cost({.x = 0, .y = 0}) == 3);
+    ASSERT(cursor.escape({.x = 0, .y = 0}) == "\033[H");
+}
+
+TEST(escape_c_matches_escape)
+{
+    static constexpr auto bold = escape_c(Trait::Bold);
+    static_assert(std::string_view{bold} == "\033[22;23;24;25;27;28;29;1m");
+
+    static constexpr auto red = escape_c(fg(XColor::Red));
+    ASSERT(std::string_view{red} == escape_fg(XColor::Red));
+
+    static constexpr auto styled = escape_c(
+        Cursor{.x = 3, .y = 4}, bg(TrueColor{RGB{255, 0, 128}}), fg(TermColor::Default),
+        Trait::Standout | Trait::DoubleUnderline, BlankRow{});
+    ASSERT(std::string_view{styled} ==
+           escape(Cursor{.x = 3, .y = 4}, bg(TrueColor{RGB{255, 0, 128}}),
+                  fg(TermColor::Default), Trait::Standout | Trait::DoubleUnderline,
+                  BlankRow{}));
+
+    auto constexpr brush = Brush{
+        .background = TrueColor{RGB{255, 255, 255}},
+        .foreground = XColor{200},
+        .traits = Trait::Bold | Trait::Italic,
+    };
+    static constexpr auto full = escape_c(brush);
+    ASSERT(std::string_view{full} == escape(brush));
+}
+
+TEST(seq_is_static)
+{
+    static_assert(seq<BlankScreen{}> == "\033[2J");
+    static_assert(seq<Cursor{.x = 0, .y = 0}, BlankRow{}> == "\033[1;1H\033[2K");
+    static_assert(seq<Trait::Bold | Trait::Underline> ==
+                  "\033[22;23;24;25;27;28;29;1;4m");
+    ASSERT(seq<Trait::Italic> == escape(Trait::Italic));
+
+    // Each instantiation has a single copy in static storage.
+    ASSERT(seq<Trait::Italic>.data() == seq<Trait::Italic>.data());
+}
+
+TEST(append_int_matches_to_string)
+{
+    auto out = std::string{};
+    for (auto i = -1'000; i < 70'000; ++i) {
+        out.clear();
+        detail::append_int(out, i);
+        ASSERT(out == std::to_string(i));
+    }
+    for (auto i : {INT_MIN, INT_MIN + 1, -99'999, 99'999, 1'000'000, INT_MAX}) {
+        out.clear();
+        detail::append_int(out, i);
+        ASSERT(out == std::to_string(i));
+    }
+    for (auto i = 0; i < 256; ++i) {
+        out.clear();
+        detail::append_uint8(out, static_cast<std::uint8_t>(i));
+        ASSERT(out == std::to_string(i));
+    }
+}
@@ -0,0 +1,119 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include <zzz/test.hpp>
+
+#include <esc/terminfo.hpp>
+
+using namespace esc;
+
+namespace {
+
+void put_short(std::string& bytes, int value)
+{
+    bytes.push_back(static_cast<char>(value & 0xFF));
+    bytes.push_back(static_cast<char>((value >> 8) & 0xFF));
+}
+
+void put_number(std::string& bytes, int value, bool wide)
+{
+    put_short(bytes, value);
+    if (wide) {
+        put_short(bytes, value >> 16);
+    }
+}
+
+/**
+ * Build a compiled terminfo file with bw, am, cols, cbt and bel, and the extended
+ * capabilities Tc and Smulx.
+ */
+[[nodiscard]] auto compiled_entry(bool wide) -> std::string
+{
+    auto bytes = std::string{};
+    auto const names = std::string_view{"test|test terminal"};
+    put_short(bytes, wide ? 01036 : 0432);
+    put_short(bytes, static_cast<int>(names.size() + 1));
+    put_short(bytes, 2);  // bw and am.
+    put_short(bytes, 1);  // cols.
+    put_short(bytes, 2);  // cbt and bel.
+    put_short(bytes, 2);  // String table size.
+    bytes.append(names).push_back('\0');
+    bytes.append({'\0', '\1'});
+    if (bytes.size() % 2 != 0) {
+        bytes.push_back('\0');
+    }
+    put_number(bytes, wide ? 100'000 : 80, wide);
+    put_short(bytes, -1);
+    put_short(bytes, 0);
+    bytes.append({'\a', '\0'});
+
+    // Extended section, Tc and Smulx.
+    auto const table = std::string{"\033[4:%p1%dm\0Tc\0Smulx\0", 20};
+    if (bytes.size() % 2 != 0) {
+        bytes.push_back('\0');
+    }
+    put_short(bytes, 1);
+    put_short(bytes, 0);
+    put_short(bytes, 1);
+    put_short(bytes, 3);
+    put_short(bytes, static_cast<int>(table.size()));
+    bytes.append({'\1', '\0'});
+    put_short(bytes, 0);   // Smulx value.
+    put_short(bytes, 0);   // Tc name.
+    put_short(bytes, 3);   // Smulx name.
+    bytes.append(table);
+    return bytes;
+}
+
+[[nodiscard]] auto write_file(std::string const& name, std::string const& bytes)
+    -> std::string
+{
+    auto const path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream{path, std::ios::binary} << bytes;
+    return path;
+}
+
+}  // namespace
+
+TEST(terminfo_compiled_entry)
+{
+    for (auto const wide : {false, true}) {
+        auto const path = write_file("escape.terminfo.test", compiled_entry(wide));
+        auto const terminfo = Terminfo::open(path);
+        std::filesystem::remove(path);
+        ASSERT(terminfo.has_value());
+
+        ASSERT(terminfo->names() == "test|test terminal");
+        ASSERT(terminfo->flag("am"));
+        ASSERT(!terminfo->flag("bw"));
+        ASSERT(!terminfo->flag("xenl"));
+        ASSERT(terminfo->number("cols") == (wide ? 100'000 : 80));
+        ASSERT(!terminfo->number("colors").has_value());
+        ASSERT(!terminfo->string("cbt").has_value());
+        ASSERT(terminfo->string("bel") == "\a");
+
+        ASSERT(terminfo->flag("Tc"));
+        ASSERT(terminfo->string("Smulx") == "\033[4:%p1%dm");
+        ASSERT(!terminfo->number("Smulx").has_value());
+        ASSERT(!terminfo->string("Tc").has_value());
+    }
+}
+
+TEST(terminfo_invalid_files)
+{
+    auto bytes = compiled_entry(false);
+    bytes[0] = 'x';
+    auto path = write_file("escape.terminfo.test", bytes);
+    ASSERT(!Terminfo::open(path).has_value());
+
+    // Truncated before the string table.
+    path = write_file("escape.terminfo.test", compiled_entry(false).substr(0, 30));
+    ASSERT(!Terminfo::open(path).has_value());
+    std::filesystem::remove(path);
+
+    ASSERT(!Terminfo::open("/no/such/terminfo/file").has_value());
+    ASSERT(load_terminfo("no/such/terminal") == nullptr);
+}
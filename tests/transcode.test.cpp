@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <zzz/test.hpp>
+
+#include <esc/detail/transcode.hpp>
+
+using namespace esc::detail;
+
+namespace {
+
+/**
+ * Encode one code point at a time, as a reference for the bulk encoder.
+ */
+[[nodiscard]] auto reference_u8(std::u32string_view sv) -> std::string
+{
+    auto result = std::string{};
+    for (auto c : sv) {
+        result.append(u32_to_u8(c));
+    }
+    return result;
+}
+
+}  // namespace
+
+TEST(u32_to_u8_ascii_and_two_byte_runs)
+{
+    // Lengths around the 8 and 16 code point blocks, so the vector paths and the
+    // scalar tail are all exercised.
+    for (auto length : {0, 1, 7, 8, 9, 15, 16, 17, 31, 32, 33, 100}) {
+        auto const n = static_cast<std::size_t>(length);
+        auto const ascii = std::u32string(n, U'a');
+        ASSERT(u32_to_u8(ascii) == std::string(n, 'a'));
+
+        auto const two_byte = std::u32string(n, U'é');
+        ASSERT(u32_to_u8(two_byte) == reference_u8(two_byte));
+    }
+
+    auto const edges = std::u32string{U"\u007F\u0080߿\u0080߿ĀЀ"
+                                      U"א\u0000\u0001\u007FA"};
+    ASSERT(u32_to_u8(edges) == reference_u8(edges));
+}
+
+TEST(u32_to_u8_mixed_blocks)
+{
+    auto text = std::u32string{};
+    for (auto i = 0; i < 10; ++i) {
+        text += U"plain ascii text, ";
+        text += U"ünïcödé ";
+        text += U"漢字かな ";
+        text += U"🙂🚀 ";
+        text += U"αβγδεζηθικλμνξοπ";
+    }
+    ASSERT(u32_to_u8(text) == reference_u8(text));
+
+    auto out = std::string{"prefix"};
+    u32_to_u8_append(text, out);
+    ASSERT(out == "prefix" + reference_u8(text));
+}
+
+TEST(u8_length_matches_encoding)
+{
+    for (auto c : std::u32string_view{U"a\u007F\u0080߿ࠀ￿🙂\U0010FFFF"}) {
+        ASSERT(u8_length(c) == u32_to_u8(c).size());
+    }
+}
+
+TEST(u8_to_u32_round_trip)
+{
+    for (auto length : {0, 1, 15, 16, 17, 31, 32, 33, 100}) {
+        auto const ascii = std::string(static_cast<std::size_t>(length), 'z');
+        ASSERT(u8_string_to_u32_string(ascii) ==
+               std::u32string(static_cast<std::size_t>(length), U'z'));
+    }
+
+    auto text = std::u32string{};
+    for (auto i = 0; i < 10; ++i) {
+        text += U"a log line with some plain ascii text in it, ";
+        text += U"ünïcödé 漢字かな 🙂🚀\n";
+    }
+    ASSERT(u8_string_to_u32_string(u32_to_u8(text)) == text);
+
+    auto out = std::u32string{U"prefix"};
+    u8_to_u32_append(u32_to_u8(text), out);
+    ASSERT(out == U"prefix" + text);
+}
+
+TEST(u8_to_u32_rejects_invalid)
+{
+    auto const throws = [](std::string const& bytes) {
+        try {
+            (void)u8_string_to_u32_string(bytes);
+        }
+        catch (std::runtime_error const&) {
+            return true;
+        }
+        return false;
+    };
+
+    auto const ascii = std::string(40, 'a');
+    ASSERT(throws(ascii + "\x80"));                   // Lone continuation byte.
+    ASSERT(throws(ascii + "\xC3"));                   // Truncated sequence.
+    ASSERT(throws("\xC0\xAF" + ascii));               // Overlong encoding.
+    ASSERT(throws(ascii + "\xED\xA0\x80" + ascii));  // Surrogate.
+    ASSERT(throws("\xF4\x90\x80\x80"));               // Past U+10FFFF.
+    ASSERT(!throws(ascii + "\xC3\xA9" + ascii));
+
+    // A failed append leaves the output as it was.
+    auto out = std::u32string{U"prefix"};
+    try {
+        u8_to_u32_append(ascii + "\x80", out);
+    }
+    catch (std::runtime_error const&) {
+    }
+    ASSERT(out == U"prefix");
+}
@@ -1,13 +1,13 @@
 #!/usr/bin/bash
 
-# Emits certain information about each entry in the terminfo db.
+# Emits certain information about each entry in the terminfo db, sorted by name for
+# the binary search in src/terminfo.cpp.
 
 ti_dir=/usr/share/terminfo
 
-for filename in $(find ${ti_dir} -type f); do
-    term_name=$(basename ${filename})
+for term_name in $(find ${ti_dir} -type f -printf '%f\n' | LC_ALL=C sort -u); do
     color_count=$(tput -T ${term_name} colors | sed 's/-1/8/')
     # xm=$(tput -T ${term_name} XM)
-    echo "Terminfo {\""${term_name}"\", "${color_count}"},"
+    echo "TerminfoEntry{\""${term_name}"\", "${color_count}"},"
     echo ${xm}
 done